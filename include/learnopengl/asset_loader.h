@@ -0,0 +1,201 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <learnopengl/thread_pool.h>
+#include <learnopengl/upload_queue.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class AssetState {
+    Unloaded,
+    Loading,
+    Ready,
+    Failed
+};
+
+// Shared reference to an asset that is loaded in the background. The asset object exists from the start and is filled on
+// the GL thread once loading completes; until Ready() it must not be drawn, so render code skips or substitutes it:
+//
+//     if (skybox)
+//         glBindTexture(GL_TEXTURE_CUBE_MAP, skybox->get());
+//
+// State is only changed on the GL thread, so handles are read there without synchronization.
+template<class T>
+class AssetHandle
+{
+public:
+    AssetHandle() {}
+
+    static AssetHandle Create()
+    {
+        AssetHandle handle;
+        handle.shared = std::make_shared<Shared>();
+        return handle;
+    }
+
+    bool Ready() const { return shared && shared->state == AssetState::Ready; }
+    explicit operator bool() const { return Ready(); }
+    AssetState State() const { return shared ? shared->state : AssetState::Unloaded; }
+
+    T &operator*() const { return shared->asset; }
+    T *operator->() const { return &shared->asset; }
+
+    // GL thread, for loaders
+    void SetState(AssetState state) const { shared->state = state; }
+
+private:
+    struct Shared {
+        T asset;
+        AssetState state = AssetState::Unloaded;
+    };
+
+    std::shared_ptr<Shared> shared;
+};
+
+// Background loading for everything the first frames can do without. Each request runs a CPU stage on the shared
+// ThreadPool (whose ParallelFor the stage may use in turn) and hands the GL job it returns back to the GL thread, which
+// runs finished jobs in Poll() within a per-frame time budget so uploads cannot stall a frame for long. Requests
+// waiting for a worker start in order of priority, highest first; callers re-prioritize them as the view changes (e.g.
+// by projected size on screen), so whatever matters most on screen arrives first.
+//
+//     AssetLoader loader;
+//     AssetHandle<TextureHandle> skybox = loader.Load<TextureHandle>(decodeFaces, uploadCubemap, 1.0f);
+//     while (running)
+//     {
+//         loader.Poll(std::chrono::milliseconds(4));
+//         ...
+//     }
+class AssetLoader
+{
+public:
+    typedef std::function<void()> GLJob;
+
+    // a queued or running request; priority may be changed and the request cancelled until its GL job has run
+    struct Request {
+        std::function<GLJob()> work;
+        float priority;
+        std::atomic<bool> cancelled{false};
+    };
+    typedef std::shared_ptr<Request> RequestPtr;
+
+    AssetLoader() : pending(0) {}
+
+    ~AssetLoader()
+    {
+        // queued requests still start on the shared pool; skip their work and wait until no task refers to the loader
+        std::unique_lock<std::mutex> lock(mutex);
+        for (const RequestPtr &request : queued)
+            request->cancelled = true;
+        drained.wait(lock, [this]() { return tasks == 0; });
+    }
+
+    AssetLoader(const AssetLoader &) = delete;
+    AssetLoader &operator=(const AssetLoader &) = delete;
+
+    // queues work for a worker; the GL job it returns runs on the GL thread during Poll() or Finish()
+    RequestPtr Submit(std::function<GLJob()> work, float priority = 0.0f)
+    {
+        RequestPtr request = std::make_shared<Request>();
+        request->work = std::move(work);
+        request->priority = priority;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued.push_back(request);
+            tasks++;
+        }
+        pending++;
+        // every task starts whichever queued request has the highest priority at that moment, not necessarily this one
+        ThreadPool::Instance().Submit([this]() {
+            runNext();
+            // notified under the lock, so the destructor cannot return before this task is done with the loader
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--tasks == 0)
+                drained.notify_all();
+        });
+        return request;
+    }
+
+    // loads an asset of type T: import() runs on a worker and its result is passed to upload(T &, result &) on the GL
+    // thread, which returns whether the asset is usable
+    template<class T, class Import, class Upload>
+    AssetHandle<T> Load(Import import, Upload upload, float priority = 0.0f)
+    {
+        AssetHandle<T> handle = AssetHandle<T>::Create();
+        handle.SetState(AssetState::Loading);
+        Submit([handle, import, upload]() {
+            auto data = std::make_shared<decltype(import())>(import());
+            return GLJob([handle, data, upload]() {
+                handle.SetState(upload(*handle, *data) ? AssetState::Ready : AssetState::Failed);
+            });
+        }, priority);
+        return handle;
+    }
+
+    void SetPriority(const RequestPtr &request, float priority)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        request->priority = priority;
+    }
+
+    // a request cancelled before it starts never runs its work; one that has started has its GL job skipped
+    void Cancel(const RequestPtr &request)
+    {
+        request->cancelled = true;
+    }
+
+    // GL thread, once per frame: runs finished GL jobs until budget is used up; at least one runs if any is waiting
+    unsigned int Poll(std::chrono::microseconds budget)
+    {
+        return uploads.DrainUntil(std::chrono::steady_clock::now() + budget);
+    }
+
+    // GL thread: runs GL jobs as requests complete until none are outstanding
+    void Finish()
+    {
+        while (pending > 0)
+        {
+            if (uploads.Drain() == 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    // requests whose GL job has not run yet
+    unsigned int Pending() const { return pending; }
+
+private:
+    void runNext()
+    {
+        RequestPtr request;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto best = queued.begin();
+            for (auto it = queued.begin(); it != queued.end(); ++it)
+                if ((*it)->priority > (*best)->priority)
+                    best = it;
+            request = *best;
+            queued.erase(best);
+        }
+        GLJob job = request->cancelled ? GLJob() : request->work();
+        request->work = nullptr;
+        uploads.Push([this, request, job]() {
+            pending--;
+            if (job && !request->cancelled)
+                job();
+        });
+    }
+
+    std::atomic<unsigned int> pending;
+    std::mutex mutex;
+    std::condition_variable drained;
+    unsigned int tasks = 0;     // submitted to the pool and not finished yet
+    std::vector<RequestPtr> queued;
+    UploadQueue uploads;
+};
+#endif
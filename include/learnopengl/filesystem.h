@@ -2,7 +2,10 @@
 #define FILESYSTEM_H
 
 #include <string>
+#include <vector>
 #include <cstdlib>
+#include <dirent.h>
+#include <sys/stat.h>
 #include "root_directory.h" // This is a configuration file generated by CMake.
 
 class FileSystem
@@ -17,6 +20,36 @@ public:
     return (*pathBuilder)(path);
   }
 
+  // appends the path of every regular file below directory, recursively; directories in skip are not entered
+  static void listFiles(const std::string& directory, std::vector<std::string>& files,
+                        const std::vector<std::string>& skip = std::vector<std::string>())
+  {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+      return;
+    while (dirent* entry = readdir(dir))
+    {
+      std::string name = entry->d_name;
+      if (name == "." || name == "..")
+        continue;
+      std::string path = directory + "/" + name;
+      struct stat st;
+      if (stat(path.c_str(), &st) != 0)
+        continue;
+      if (S_ISDIR(st.st_mode))
+      {
+        bool skipped = false;
+        for (const std::string& excluded : skip)
+          skipped = skipped || path == excluded;
+        if (!skipped)
+          listFiles(path, files, skip);
+      }
+      else if (S_ISREG(st.st_mode))
+        files.push_back(path);
+    }
+    closedir(dir);
+  }
+
 private:
   static std::string const & getRoot()
   {
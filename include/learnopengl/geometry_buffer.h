@@ -0,0 +1,324 @@
+#ifndef GEOMETRY_BUFFER_H
+#define GEOMETRY_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_handle.h>
+#include <learnopengl/vertex_format.h>
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <utility>
+
+// First-fit allocator over the range [0, capacity). Free blocks are kept sorted by offset and coalesced with their
+// neighbours when released, so the free list only fragments where live allocations separate free space.
+class FreeListAllocator
+{
+public:
+    static const size_t InvalidOffset = ~(size_t) 0;
+
+    explicit FreeListAllocator(size_t initialCapacity = 0)
+    {
+        Grow(initialCapacity);
+    }
+
+    // returns the offset of a block of size units aligned to alignment, or InvalidOffset if no free block is large enough
+    size_t Allocate(size_t size, size_t alignment = 1)
+    {
+        for (auto block = freeBlocks.begin(); block != freeBlocks.end(); ++block)
+        {
+            size_t aligned = (block->first + alignment - 1) / alignment * alignment;
+            size_t padding = aligned - block->first;
+            if (block->second < padding + size)
+                continue;
+            size_t blockOffset = block->first;
+            size_t blockSize = block->second;
+            freeBlocks.erase(block);
+            if (padding > 0)
+                freeBlocks[blockOffset] = padding;
+            if (blockSize > padding + size)
+                freeBlocks[aligned + size] = blockSize - padding - size;
+            used += size;
+            return aligned;
+        }
+        return InvalidOffset;
+    }
+
+    void Free(size_t offset, size_t size)
+    {
+        used -= size;
+        release(offset, size);
+    }
+
+    // extends the range; the new space joins the free block at the old end, if there is one
+    void Grow(size_t newCapacity)
+    {
+        if (newCapacity <= capacity)
+            return;
+        release(capacity, newCapacity - capacity);
+        capacity = newCapacity;
+    }
+
+    size_t Capacity() const { return capacity; }
+    size_t Used() const { return used; }
+
+    size_t LargestFreeBlock() const
+    {
+        size_t largest = 0;
+        for (const auto &block : freeBlocks)
+            largest = std::max(largest, block.second);
+        return largest;
+    }
+
+    // share of the free space outside the largest free block: 0 when all free space is contiguous
+    float Fragmentation() const
+    {
+        size_t free = capacity - used;
+        return free == 0 ? 0.0f : 1.0f - (float) LargestFreeBlock() / free;
+    }
+
+private:
+    void release(size_t offset, size_t size)
+    {
+        if (size == 0)
+            return;
+        auto next = freeBlocks.lower_bound(offset);
+        if (next != freeBlocks.end() && offset + size == next->first)
+        {
+            size += next->second;
+            next = freeBlocks.erase(next);
+        }
+        if (next != freeBlocks.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                previous->second += size;
+                return;
+            }
+        }
+        freeBlocks[offset] = size;
+    }
+
+    std::map<size_t, size_t> freeBlocks;    // offset -> size
+    size_t capacity = 0;
+    size_t used = 0;
+};
+
+// One vertex buffer and one index buffer shared by every mesh packed in the same vertex format, with a single VAO
+// describing them. Vertices are allocated in whole vertices, so a mesh's first vertex is its base vertex; indices of
+// either width are allocated in bytes from one element buffer.
+class GeometryPool
+{
+public:
+    static const size_t InitialVertexBytes = 4 * 1024 * 1024;
+    static const size_t InitialIndexBytes = 2 * 1024 * 1024;
+
+    explicit GeometryPool(const PackedGeometry &format)
+    {
+        this->format.layout = format.layout;
+        this->format.fullTexCoords = format.fullTexCoords;
+        this->format.stride = format.stride;
+        vertices.Grow(InitialVertexBytes / format.stride);
+        indices.Grow(InitialIndexBytes);
+
+        VAO = CreateVertexArray();
+        VBO = CreateBuffer();
+        EBO = CreateBuffer();
+        glBindVertexArray(VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+        glBufferData(GL_ARRAY_BUFFER, vertices.Capacity() * format.stride, nullptr, GL_STATIC_DRAW);
+        this->format.SetupAttributes();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.Capacity(), nullptr, GL_STATIC_DRAW);
+        glBindVertexArray(0);
+    }
+
+    GeometryPool(const GeometryPool &) = delete;
+    GeometryPool &operator=(const GeometryPool &) = delete;
+
+    // copies geometry into the pool, growing the buffers if needed; returns the base vertex and the index byte offset
+    void Store(const PackedGeometry &geometry, size_t &baseVertex, size_t &indexOffset)
+    {
+        baseVertex = vertices.Allocate(geometry.vertexCount);
+        if (baseVertex == FreeListAllocator::InvalidOffset)
+        {
+            growVertices(geometry.vertexCount);
+            baseVertex = vertices.Allocate(geometry.vertexCount);
+        }
+        indexOffset = indices.Allocate(geometry.indices.size(), sizeof(unsigned int));
+        if (indexOffset == FreeListAllocator::InvalidOffset)
+        {
+            growIndices(geometry.indices.size() + sizeof(unsigned int));
+            indexOffset = indices.Allocate(geometry.indices.size(), sizeof(unsigned int));
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+        glBufferSubData(GL_ARRAY_BUFFER, baseVertex * format.stride, geometry.vertices.size(), geometry.vertices.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        // the element buffer binding is VAO state, so it is changed with the pool's VAO bound
+        glBindVertexArray(VAO.get());
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexOffset, geometry.indices.size(), geometry.indices.data());
+        glBindVertexArray(0);
+        meshCount++;
+    }
+
+    void Release(size_t baseVertex, size_t vertexCount, size_t indexOffset, size_t indexBytes)
+    {
+        vertices.Free(baseVertex, vertexCount);
+        indices.Free(indexOffset, indexBytes);
+        meshCount--;
+    }
+
+    unsigned int VertexArray() const { return VAO.get(); }
+
+    void PrintStats(std::ostream &out) const
+    {
+        out << "GEOMETRY_BUFFER:: format " << format.FormatKey() << " (" << format.stride << " B/vertex): " << meshCount
+            << " meshes, vertices " << vertices.Used() * format.stride / 1024 << "/" << vertices.Capacity() * format.stride / 1024
+            << " KiB (" << (int) (vertices.Fragmentation() * 100.0f) << "% fragmented), indices " << indices.Used() / 1024
+            << "/" << indices.Capacity() / 1024 << " KiB (" << (int) (indices.Fragmentation() * 100.0f) << "% fragmented)"
+            << std::endl;
+    }
+
+private:
+    // replaces buffer by a larger one holding the same contents
+    static void reallocate(BufferHandle &buffer, size_t oldBytes, size_t newBytes)
+    {
+        BufferHandle grown = CreateBuffer();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown.get());
+        glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer.get());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        buffer = std::move(grown);
+    }
+
+    void growVertices(size_t required)
+    {
+        size_t capacity = std::max(vertices.Capacity() * 2, vertices.Capacity() + required);
+        reallocate(VBO, vertices.Capacity() * format.stride, capacity * format.stride);
+        vertices.Grow(capacity);
+        glBindVertexArray(VAO.get());
+        glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
+        format.SetupAttributes();
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void growIndices(size_t required)
+    {
+        size_t capacity = std::max(indices.Capacity() * 2, indices.Capacity() + required);
+        reallocate(EBO, indices.Capacity(), capacity);
+        indices.Grow(capacity);
+        glBindVertexArray(VAO.get());
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.get());
+        glBindVertexArray(0);
+    }
+
+    PackedGeometry format;          // attribute format only, holds no data
+    FreeListAllocator vertices;     // in vertices
+    FreeListAllocator indices;      // in bytes
+    VertexArrayHandle VAO;
+    BufferHandle VBO, EBO;
+    unsigned int meshCount = 0;
+};
+
+// where one mesh lives inside its GeometryPool; move-only, the range is returned to the pool when its owner is destroyed
+struct GeometryRange {
+    GeometryPool *pool = nullptr;
+    size_t baseVertex = 0;
+    size_t vertexCount = 0;
+    size_t indexOffset = 0;     // in bytes
+    size_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    GeometryRange() {}
+    ~GeometryRange();
+    GeometryRange(const GeometryRange &) = delete;
+    GeometryRange &operator=(const GeometryRange &) = delete;
+    GeometryRange(GeometryRange &&other) noexcept { *this = std::move(other); }
+    GeometryRange &operator=(GeometryRange &&other) noexcept;
+
+    size_t IndexBytes() const { return indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int)); }
+};
+
+// Process-wide set of geometry pools, one per vertex format, shared by every Model. Allocate() and Free() issue GL calls
+// and must run on the GL thread.
+class GeometryBuffers
+{
+public:
+    static GeometryBuffers &Instance()
+    {
+        static GeometryBuffers buffers;
+        return buffers;
+    }
+
+    GeometryRange Allocate(const PackedGeometry &geometry)
+    {
+        std::unique_ptr<GeometryPool> &pool = pools[geometry.FormatKey()];
+        if (!pool)
+            pool.reset(new GeometryPool(geometry));
+
+        GeometryRange range;
+        range.pool = pool.get();
+        range.vertexCount = geometry.vertexCount;
+        range.indexCount = geometry.indexCount;
+        range.indexType = geometry.indexType;
+        pool->Store(geometry, range.baseVertex, range.indexOffset);
+        return range;
+    }
+
+    // returns a range to its pool; after Shutdown() this is a no-op
+    void Free(GeometryRange &range)
+    {
+        if (range.pool && !shutDown)
+            range.pool->Release(range.baseVertex, range.vertexCount, range.indexOffset, range.IndexBytes());
+        range.pool = nullptr;
+    }
+
+    // deletes every pool while the GL context is still current
+    void Shutdown()
+    {
+        pools.clear();
+        shutDown = true;
+    }
+
+    void PrintStats()
+    {
+        for (const auto &pool : pools)
+            pool.second->PrintStats(std::cout);
+    }
+
+private:
+    GeometryBuffers() {}
+
+    std::map<unsigned int, std::unique_ptr<GeometryPool>> pools;
+    bool shutDown = false;
+};
+
+inline GeometryRange::~GeometryRange()
+{
+    GeometryBuffers::Instance().Free(*this);
+}
+
+inline GeometryRange &GeometryRange::operator=(GeometryRange &&other) noexcept
+{
+    if (this != &other)
+    {
+        GeometryBuffers::Instance().Free(*this);
+        pool = other.pool;
+        baseVertex = other.baseVertex;
+        vertexCount = other.vertexCount;
+        indexOffset = other.indexOffset;
+        indexCount = other.indexCount;
+        indexType = other.indexType;
+        other.pool = nullptr;
+    }
+    return *this;
+}
+#endif
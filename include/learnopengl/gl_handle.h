@@ -0,0 +1,99 @@
+#ifndef GL_HANDLE_H
+#define GL_HANDLE_H
+
+#include <glad/glad.h>
+
+// Move-only owner of one GL object name, deleted when the handle is destroyed or reset. Handles must be released while
+// the context is still current, so long-lived owners (the registries) drop theirs in an explicit Shutdown().
+template<void (*Delete)(unsigned int)>
+class GLHandle
+{
+public:
+    GLHandle() {}
+    explicit GLHandle(unsigned int id) : id(id) {}
+    ~GLHandle() { reset(); }
+
+    GLHandle(const GLHandle &) = delete;
+    GLHandle &operator=(const GLHandle &) = delete;
+
+    GLHandle(GLHandle &&other) noexcept : id(other.id) { other.id = 0; }
+    GLHandle &operator=(GLHandle &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset(other.id);
+            other.id = 0;
+        }
+        return *this;
+    }
+
+    unsigned int get() const { return id; }
+    explicit operator bool() const { return id != 0; }
+
+    // deletes the owned object and takes ownership of newId
+    void reset(unsigned int newId = 0)
+    {
+        if (id)
+            Delete(id);
+        id = newId;
+    }
+
+    // gives up ownership without deleting
+    unsigned int release()
+    {
+        unsigned int released = id;
+        id = 0;
+        return released;
+    }
+
+private:
+    unsigned int id = 0;
+};
+
+inline void DeleteGLBuffer(unsigned int id) { glDeleteBuffers(1, &id); }
+inline void DeleteGLVertexArray(unsigned int id) { glDeleteVertexArrays(1, &id); }
+inline void DeleteGLTexture(unsigned int id) { glDeleteTextures(1, &id); }
+inline void DeleteGLFramebuffer(unsigned int id) { glDeleteFramebuffers(1, &id); }
+inline void DeleteGLRenderbuffer(unsigned int id) { glDeleteRenderbuffers(1, &id); }
+
+typedef GLHandle<DeleteGLBuffer> BufferHandle;
+typedef GLHandle<DeleteGLVertexArray> VertexArrayHandle;
+typedef GLHandle<DeleteGLTexture> TextureHandle;
+typedef GLHandle<DeleteGLFramebuffer> FramebufferHandle;
+typedef GLHandle<DeleteGLRenderbuffer> RenderbufferHandle;
+
+inline BufferHandle CreateBuffer()
+{
+    unsigned int id;
+    glGenBuffers(1, &id);
+    return BufferHandle(id);
+}
+
+inline VertexArrayHandle CreateVertexArray()
+{
+    unsigned int id;
+    glGenVertexArrays(1, &id);
+    return VertexArrayHandle(id);
+}
+
+inline TextureHandle CreateTexture()
+{
+    unsigned int id;
+    glGenTextures(1, &id);
+    return TextureHandle(id);
+}
+
+inline FramebufferHandle CreateFramebuffer()
+{
+    unsigned int id;
+    glGenFramebuffers(1, &id);
+    return FramebufferHandle(id);
+}
+
+inline RenderbufferHandle CreateRenderbuffer()
+{
+    unsigned int id;
+    glGenRenderbuffers(1, &id);
+    return RenderbufferHandle(id);
+}
+#endif
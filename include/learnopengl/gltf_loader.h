@@ -0,0 +1,417 @@
+#ifndef GLTF_LOADER_H
+#define GLTF_LOADER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/import_profile.h>
+#include <learnopengl/json.h>
+#include <learnopengl/mesh_attributes.h>
+#include <learnopengl/node_hierarchy.h>
+#include <learnopengl/virtual_file_system.h>
+#include <learnopengl/mesh.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Native glTF 2.0 importer used by Model::Import instead of ASSIMP for .gltf files.
+//
+// The external .bin buffers are read in place through the VirtualFileSystem (mapped loose files or pack views) and
+// every accessor is converted in one pass straight into the final Vertex array, without the aiMesh copy in between. The
+// result matches what Model::processNode produces from ASSIMP: one MeshData per primitive per node referencing it, in
+// depth-first node order, with the same texture slots (base color or KHR_materials_pbrSpecularGlossiness diffuse as
+// texture_diffuse, its specular-glossiness map as texture_specular).
+//
+// Node transforms are baked into the vertices, except below nodes an animation targets: those are kept in a
+// NodeHierarchy and their meshes baked relative to them (see NodeHierarchy). From the ImportProfile it honours
+// pretransform (animated nodes are baked as well and none are kept), mergeMeshes, normals, tangents and flipUVs;
+// welding and reordering are left to MeshOptimizer, and mergeGraph/dedupMaterials only apply to ASSIMP. Files using
+// embedded data: URIs, sparse accessors or anything else it does not read return false, and the caller falls back to
+// ASSIMP.
+class GltfLoader
+{
+public:
+    static bool Handles(const std::string &path)
+    {
+        return path.size() > 5 && path.compare(path.size() - 5, 5, ".gltf") == 0;
+    }
+
+    bool Load(const std::string &path, const ImportProfile &profile, std::vector<MeshData> &meshes, NodeHierarchy &nodes)
+    {
+        this->profile = profile;
+        directory = path.substr(0, path.find_last_of('/'));
+        FileView file = VirtualFileSystem::Instance().Open(path);
+        if (!file || !JsonValue::Parse(file.String(), document))
+        {
+            std::cout << "ERROR::GLTF:: could not parse " << path << std::endl;
+            return false;
+        }
+
+        const JsonValue &buffersJson = document["buffers"];
+        for (size_t i = 0; i < buffersJson.Size(); i++)
+        {
+            const std::string &uri = buffersJson[i]["uri"].String();
+            if (uri.empty() || uri.compare(0, 5, "data:") == 0)
+                return false;
+            FileView buffer = VirtualFileSystem::Instance().Open(directory + '/' + decodeUri(uri));
+            if (!buffer || buffer.size < (size_t) buffersJson[i]["byteLength"].Number())
+                return false;
+            buffers.push_back(std::move(buffer));
+        }
+
+        animated.assign(document["nodes"].Size(), 0);
+        const JsonValue &animations = document["animations"];
+        for (size_t i = 0; i < animations.Size() && !profile.pretransform; i++)
+        {
+            const JsonValue &channels = animations[i]["channels"];
+            for (size_t c = 0; c < channels.Size(); c++)
+            {
+                int target = channels[c]["target"]["node"].Int(-1);
+                if (target >= 0 && (size_t) target < animated.size())
+                    animated[target] = 1;
+            }
+        }
+
+        const JsonValue &scene = document["scenes"][document["scene"].Int(0)];
+        const JsonValue &roots = scene.IsNull() ? JsonValue() : scene["nodes"];
+        for (size_t i = 0; i < roots.Size(); i++)
+            if (!processNode(roots[i].Int(-1), glm::mat4(1.0f), NodeHierarchy::NoNode, meshes, nodes, 0))
+                return false;
+        if (profile.mergeMeshes)
+            mergeByMaterial(meshes);
+        return true;
+    }
+
+private:
+    // a validated accessor: count elements of components values each, stride bytes apart
+    struct Accessor {
+        const unsigned char *data = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        int componentType = 0;
+        int components = 0;
+        bool normalized = false;
+    };
+
+    static const int MaxNodeDepth = 64;
+
+    static std::string decodeUri(const std::string &uri)
+    {
+        std::string decoded;
+        for (size_t i = 0; i < uri.size(); i++)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size())
+            {
+                decoded += (char) strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16);
+                i += 2;
+            }
+            else
+                decoded += uri[i];
+        }
+        return decoded;
+    }
+
+    static size_t componentSize(int componentType)
+    {
+        switch (componentType)
+        {
+            case 5120: case 5121: return 1;  // BYTE, UNSIGNED_BYTE
+            case 5122: case 5123: return 2;  // SHORT, UNSIGNED_SHORT
+            case 5125: case 5126: return 4;  // UNSIGNED_INT, FLOAT
+            default: return 0;
+        }
+    }
+
+    static int componentCount(const std::string &type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        if (type == "MAT4") return 16;
+        return 0;
+    }
+
+    bool accessor(int index, Accessor &result) const
+    {
+        const JsonValue &json = document["accessors"][index];
+        const JsonValue &view = document["bufferViews"][json["bufferView"].Int(-1)];
+        if (json.IsNull() || view.IsNull() || json.Has("sparse"))
+            return false;
+        int buffer = view["buffer"].Int(-1);
+        if (buffer < 0 || (size_t) buffer >= buffers.size())
+            return false;
+
+        result.componentType = json["componentType"].Int();
+        result.components = componentCount(json["type"].String());
+        result.normalized = json["normalized"].Bool();
+        result.count = (size_t) json["count"].Number();
+        size_t elementSize = componentSize(result.componentType) * result.components;
+        result.stride = view.Has("byteStride") ? (size_t) view["byteStride"].Number() : elementSize;
+        size_t offset = (size_t) view["byteOffset"].Number() + (size_t) json["byteOffset"].Number();
+        size_t viewEnd = (size_t) view["byteOffset"].Number() + (size_t) view["byteLength"].Number();
+        if (elementSize == 0 || viewEnd > buffers[buffer].size
+            || (result.count > 0 && offset + result.stride * (result.count - 1) + elementSize > viewEnd))
+            return false;
+        result.data = buffers[buffer].data + offset;
+        return true;
+    }
+
+    static float component(const unsigned char *at, int componentType, bool normalized)
+    {
+        switch (componentType)
+        {
+            case 5126: { float v; memcpy(&v, at, 4); return v; }
+            case 5120: { int8_t v; memcpy(&v, at, 1); return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+            case 5121: { uint8_t v = *at; return normalized ? v / 255.0f : v; }
+            case 5122: { int16_t v; memcpy(&v, at, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+            case 5123: { uint16_t v; memcpy(&v, at, 2); return normalized ? v / 65535.0f : v; }
+            case 5125: { uint32_t v; memcpy(&v, at, 4); return (float) v; }
+            default: return 0.0f;
+        }
+    }
+
+    // calls visit(i, values) for every element; float data, the common case, is copied without per-component dispatch
+    template<typename Visit>
+    static void forEach(const Accessor &view, Visit visit)
+    {
+        float values[16];
+        size_t size = componentSize(view.componentType);
+        for (size_t i = 0; i < view.count; i++)
+        {
+            const unsigned char *element = view.data + i * view.stride;
+            if (view.componentType == 5126)
+                memcpy(values, element, sizeof(float) * view.components);
+            else
+                for (int c = 0; c < view.components; c++)
+                    values[c] = component(element + c * size, view.componentType, view.normalized);
+            visit(i, values);
+        }
+    }
+
+    static glm::mat4 localTransform(const JsonValue &node)
+    {
+        glm::mat4 local(1.0f);
+        const JsonValue &matrix = node["matrix"];
+        if (matrix.Size() == 16)
+        {
+            for (int column = 0; column < 4; column++)
+                for (int row = 0; row < 4; row++)
+                    local[column][row] = (float) matrix[column * 4 + row].Number();
+            return local;
+        }
+
+        const JsonValue &t = node["translation"];
+        const JsonValue &r = node["rotation"];
+        const JsonValue &s = node["scale"];
+        float x = (float) r[0].Number(0.0), y = (float) r[1].Number(0.0), z = (float) r[2].Number(0.0), w = (float) r[3].Number(1.0);
+        glm::vec3 scale((float) s[0].Number(1.0), (float) s[1].Number(1.0), (float) s[2].Number(1.0));
+        // T * R * S with R from the unit quaternion (x, y, z, w)
+        local[0] = glm::vec4(1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0.0f) * scale.x;
+        local[1] = glm::vec4(2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0.0f) * scale.y;
+        local[2] = glm::vec4(2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0.0f) * scale.z;
+        local[3] = glm::vec4((float) t[0].Number(), (float) t[1].Number(), (float) t[2].Number(), 1.0f);
+        return local;
+    }
+
+    // frame is the transform from the node's parent to the nearest kept ancestor, kept, or to the model if there is none
+    bool processNode(int index, const glm::mat4 &frame, int kept, std::vector<MeshData> &meshes, NodeHierarchy &nodes, int depth)
+    {
+        const JsonValue &node = document["nodes"][index];
+        if (node.IsNull() || depth > MaxNodeDepth)
+            return false;
+        glm::mat4 world = frame * localTransform(node);
+        if (animated[index])
+        {
+            kept = nodes.Add(node["name"].String(), kept, world);
+            world = glm::mat4(1.0f);
+        }
+
+        if (node.Has("mesh"))
+        {
+            const JsonValue &primitives = document["meshes"][node["mesh"].Int(-1)]["primitives"];
+            for (size_t i = 0; i < primitives.Size(); i++)
+            {
+                MeshData mesh;
+                int mode = primitives[i]["mode"].Int(4);
+                if (mode < 4)
+                    continue;   // points and lines, which ASSIMP's triangulation drops as well
+                if (!processPrimitive(primitives[i], mode, world, mesh))
+                    return false;
+                mesh.node = kept;
+                meshes.push_back(std::move(mesh));
+            }
+        }
+
+        const JsonValue &children = node["children"];
+        for (size_t i = 0; i < children.Size(); i++)
+            if (!processNode(children[i].Int(-1), world, kept, meshes, nodes, depth + 1))
+                return false;
+        return true;
+    }
+
+    bool processPrimitive(const JsonValue &primitive, int mode, const glm::mat4 &world, MeshData &mesh)
+    {
+        const JsonValue &attributes = primitive["attributes"];
+        Accessor positions, normals, texCoords, tangents;
+        if (!accessor(attributes["POSITION"].Int(-1), positions) || positions.components != 3)
+            return false;
+        bool hasNormals = attributes.Has("NORMAL");
+        bool hasTexCoords = attributes.Has("TEXCOORD_0");
+        bool hasTangents = attributes.Has("TANGENT");
+        if ((hasNormals && (!accessor(attributes["NORMAL"].Int(-1), normals) || normals.count != positions.count))
+            || (hasTexCoords && (!accessor(attributes["TEXCOORD_0"].Int(-1), texCoords) || texCoords.count != positions.count))
+            || (hasTangents && (!accessor(attributes["TANGENT"].Int(-1), tangents) || tangents.count != positions.count
+                                || tangents.components != 4)))
+            return false;
+
+        Vertex zero = {};
+        std::vector<Vertex> &vertices = mesh.vertices;
+        vertices.assign(positions.count, zero);
+        forEach(positions, [&vertices](size_t i, const float *v) { vertices[i].Position = glm::vec3(v[0], v[1], v[2]); });
+        if (hasNormals)
+            forEach(normals, [&vertices](size_t i, const float *v) { vertices[i].Normal = glm::vec3(v[0], v[1], v[2]); });
+        if (hasTexCoords)
+        {
+            bool flip = profile.flipUVs;
+            forEach(texCoords, [&vertices, flip](size_t i, const float *v) {
+                vertices[i].TexCoords = glm::vec2(v[0], flip ? 1.0f - v[1] : v[1]);
+            });
+        }
+
+        std::vector<unsigned int> &indices = mesh.indices;
+        std::vector<unsigned int> elements;
+        if (primitive.Has("indices"))
+        {
+            Accessor indexView;
+            if (!accessor(primitive["indices"].Int(-1), indexView) || indexView.components != 1)
+                return false;
+            elements.resize(indexView.count);
+            forEach(indexView, [&elements](size_t i, const float *v) { elements[i] = (unsigned int) v[0]; });
+            for (unsigned int element : elements)
+                if (element >= vertices.size())
+                    return false;
+        }
+        else
+        {
+            elements.resize(vertices.size());
+            for (size_t i = 0; i < elements.size(); i++)
+                elements[i] = (unsigned int) i;
+        }
+        triangulate(mode, elements, indices);
+
+        if (!hasNormals && profile.normals == ImportProfile::FlatNormals)
+            MeshAttributes::GenerateFlatNormals(vertices, indices);
+        else if (!hasNormals && profile.normals == ImportProfile::SmoothNormals)
+            MeshAttributes::GenerateSmoothNormals(vertices, indices);
+        // glTF: tangents given without normals must be ignored; they would also index vertices that flat normals re-faceted
+        if (hasTangents && hasNormals)
+        {
+            forEach(tangents, [&vertices](size_t i, const float *v) {
+                vertices[i].Tangent = glm::vec3(v[0], v[1], v[2]);
+                vertices[i].Bitangent = glm::cross(vertices[i].Normal, vertices[i].Tangent) * v[3];
+            });
+        }
+        else if (profile.tangents && hasTexCoords)
+            MeshAttributes::GenerateTangents(vertices, indices);
+
+        if (world != glm::mat4(1.0f))
+            MeshAttributes::Transform(vertices, indices, world);
+        mesh.textures = materialTextures(primitive["material"].Int(-1));
+        mesh.ComputeBounds();
+        return true;
+    }
+
+    // converts strips and fans to a triangle list, keeping the winding of every triangle
+    static void triangulate(int mode, const std::vector<unsigned int> &elements, std::vector<unsigned int> &indices)
+    {
+        if (mode == 4)
+        {
+            indices.assign(elements.begin(), elements.end() - elements.size() % 3);
+            return;
+        }
+        for (size_t i = 2; i < elements.size(); i++)
+        {
+            if (mode == 5)  // TRIANGLE_STRIP
+            {
+                bool odd = i % 2 == 1;
+                indices.push_back(elements[odd ? i - 1 : i - 2]);
+                indices.push_back(elements[odd ? i - 2 : i - 1]);
+            }
+            else            // TRIANGLE_FAN
+            {
+                indices.push_back(elements[0]);
+                indices.push_back(elements[i - 1]);
+            }
+            indices.push_back(elements[i]);
+        }
+    }
+
+    // appends every mesh to the first one with the same textures below the same kept node, like aiProcess_OptimizeMeshes
+    static void mergeByMaterial(std::vector<MeshData> &meshes)
+    {
+        std::vector<MeshData> merged;
+        for (MeshData &mesh : meshes)
+        {
+            MeshData *target = nullptr;
+            for (MeshData &candidate : merged)
+                if (candidate.node == mesh.node && sameTextures(candidate.textures, mesh.textures))
+                    target = &candidate;
+            if (!target)
+            {
+                merged.push_back(std::move(mesh));
+                continue;
+            }
+            unsigned int base = (unsigned int) target->vertices.size();
+            target->vertices.insert(target->vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+            for (unsigned int index : mesh.indices)
+                target->indices.push_back(base + index);
+            target->boundsMin = glm::min(target->boundsMin, mesh.boundsMin);
+            target->boundsMax = glm::max(target->boundsMax, mesh.boundsMax);
+        }
+        meshes.swap(merged);
+    }
+
+    static bool sameTextures(const std::vector<TextureRef> &a, const std::vector<TextureRef> &b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); i++)
+            if (a[i].type != b[i].type || a[i].path != b[i].path)
+                return false;
+        return true;
+    }
+
+    std::vector<TextureRef> materialTextures(int materialIndex) const
+    {
+        std::vector<TextureRef> textures;
+        const JsonValue &material = document["materials"][materialIndex];
+        const JsonValue &specularGlossiness = material["extensions"]["KHR_materials_pbrSpecularGlossiness"];
+        const JsonValue &diffuse = specularGlossiness.IsNull() ? material["pbrMetallicRoughness"]["baseColorTexture"]
+                                                               : specularGlossiness["diffuseTexture"];
+        addTexture(diffuse, "texture_diffuse", textures);
+        addTexture(specularGlossiness["specularGlossinessTexture"], "texture_specular", textures);
+        return textures;
+    }
+
+    void addTexture(const JsonValue &textureInfo, const std::string &type, std::vector<TextureRef> &textures) const
+    {
+        if (textureInfo.IsNull())
+            return;
+        const JsonValue &texture = document["textures"][textureInfo["index"].Int(-1)];
+        const std::string &uri = document["images"][texture["source"].Int(-1)]["uri"].String();
+        if (!uri.empty() && uri.compare(0, 5, "data:") != 0)
+            textures.push_back(TextureRef{type, decodeUri(uri)});
+    }
+
+    ImportProfile profile;
+    std::string directory;
+    JsonValue document;
+    std::vector<FileView> buffers;
+    std::vector<unsigned char> animated;   // per node, whether an animation targets it
+};
+#endif
@@ -0,0 +1,157 @@
+#ifndef IMPORT_PROFILE_H
+#define IMPORT_PROFILE_H
+
+#include <assimp/postprocess.h>
+
+#include <learnopengl/hash.h>
+#include <learnopengl/virtual_file_system.h>
+
+#include <cstdint>
+#include <sstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// How one model is imported: the ASSIMP post-processing steps and the MeshOptimizer stages run on it.
+//
+// Profiles are declarative "key = value" files ('#' starts a comment). For resources/objects/hornet/scene.gltf the files
+//     resources/import.profile
+//     resources/objects/import.profile
+//     resources/objects/hornet/import.profile
+//     resources/objects/hornet/scene.gltf.profile
+// are applied in that order where they exist, each overriding the keys it sets. Keys:
+//     weld           = true|false          merge identical vertices (aiProcess_JoinIdenticalVertices + MeshOptimizer)
+//     optimize       = true|false          vertex cache, overdraw and vertex fetch reordering
+//     mergeMeshes    = true|false          join meshes of a node sharing a material (aiProcess_OptimizeMeshes)
+//     mergeGraph     = true|false          collapse nodes that need no separate transform (aiProcess_OptimizeGraph)
+//     pretransform   = true|false          bake animated nodes too, keeping no NodeHierarchy (aiProcess_PreTransformVertices)
+//     normals        = keep|flat|smooth    generate missing normals
+//     tangents       = true|false          generate tangents and bitangents (aiProcess_CalcTangentSpace)
+//     dedupMaterials = true|false          drop duplicate materials (aiProcess_RemoveRedundantMaterials)
+//     flipUVs        = true|false          aiProcess_FlipUVs
+//     recenter       = true|false          move the model origin to the bottom center of its bounds
+// Every mesh cache entry is keyed by Key(), so editing a profile re-imports only the models it applies to.
+struct ImportProfile {
+    enum Normals { KeepNormals, FlatNormals, SmoothNormals };
+
+    bool weld = true;
+    bool optimize = true;
+    bool mergeMeshes = false;
+    bool mergeGraph = false;
+    bool pretransform = false;
+    Normals normals = SmoothNormals;
+    bool tangents = true;
+    bool dedupMaterials = false;
+    bool flipUVs = true;
+    bool recenter = false;
+
+    unsigned int PostProcessFlags() const
+    {
+        unsigned int flags = aiProcess_Triangulate;
+        if (weld)
+            flags |= aiProcess_JoinIdenticalVertices;
+        if (mergeMeshes)
+            flags |= aiProcess_OptimizeMeshes;
+        if (mergeGraph)
+            flags |= aiProcess_OptimizeGraph;
+        if (pretransform)
+            flags |= aiProcess_PreTransformVertices;
+        if (normals == FlatNormals)
+            flags |= aiProcess_GenNormals;
+        else if (normals == SmoothNormals)
+            flags |= aiProcess_GenSmoothNormals;
+        if (tangents)
+            flags |= aiProcess_CalcTangentSpace;
+        if (dedupMaterials)
+            flags |= aiProcess_RemoveRedundantMaterials;
+        if (flipUVs)
+            flags |= aiProcess_FlipUVs;
+        return flags;
+    }
+
+    // identifies everything that influences the imported geometry
+    uint64_t Key() const
+    {
+        unsigned int flags = PostProcessFlags();
+        uint64_t key = HashBytes(&flags, sizeof(flags));
+        unsigned char stages[3] = {weld, optimize, recenter};
+        return HashBytes(stages, sizeof(stages), key);
+    }
+
+    // profile for the model file at path, assembled from every profile file that applies to it
+    static ImportProfile ForModel(const std::string &path)
+    {
+        std::vector<std::string> files;
+        files.push_back(path + ".profile");
+        for (size_t slash = path.find_last_of('/'); slash != std::string::npos && slash > 0; slash = path.find_last_of('/', slash - 1))
+            files.push_back(path.substr(0, slash) + "/import.profile");
+
+        ImportProfile profile;
+        for (auto file = files.rbegin(); file != files.rend(); ++file)
+            profile.Apply(*file);
+        return profile;
+    }
+
+    // overrides the keys set in the profile file at path; a missing file leaves the profile unchanged
+    bool Apply(const std::string &path)
+    {
+        FileView contents = VirtualFileSystem::Instance().Open(path);
+        if (!contents)
+            return false;
+        std::istringstream file(contents.String());
+        std::string line;
+        for (int number = 1; std::getline(file, line); number++)
+        {
+            line = line.substr(0, line.find('#'));
+            size_t equals = line.find('=');
+            std::string key = trim(line.substr(0, equals));
+            if (key.empty())
+                continue;
+            std::string value = equals == std::string::npos ? "" : trim(line.substr(equals + 1));
+            if (!Set(key, value))
+                std::cout << "ERROR::IMPORT_PROFILE:: " << path << ":" << number << ": invalid setting '" << key << " = "
+                          << value << "'" << std::endl;
+        }
+        return true;
+    }
+
+    bool Set(const std::string &key, const std::string &value)
+    {
+        if (key == "normals")
+        {
+            if (value == "keep")
+                normals = KeepNormals;
+            else if (value == "flat")
+                normals = FlatNormals;
+            else if (value == "smooth")
+                normals = SmoothNormals;
+            else
+                return false;
+            return true;
+        }
+
+        bool *option = key == "weld"           ? &weld
+                     : key == "optimize"       ? &optimize
+                     : key == "mergeMeshes"    ? &mergeMeshes
+                     : key == "mergeGraph"     ? &mergeGraph
+                     : key == "pretransform"   ? &pretransform
+                     : key == "tangents"       ? &tangents
+                     : key == "dedupMaterials" ? &dedupMaterials
+                     : key == "flipUVs"        ? &flipUVs
+                     : key == "recenter"       ? &recenter
+                     : nullptr;
+        if (!option || (value != "true" && value != "false"))
+            return false;
+        *option = value == "true";
+        return true;
+    }
+
+private:
+    static std::string trim(const std::string &text)
+    {
+        size_t begin = text.find_first_not_of(" \t\r");
+        size_t end = text.find_last_not_of(" \t\r");
+        return begin == std::string::npos ? "" : text.substr(begin, end - begin + 1);
+    }
+};
+#endif
@@ -0,0 +1,229 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal read-only JSON document, enough for glTF and the project's own data files. Lookups of missing keys or
+// out-of-range elements return a shared null value, so chains like doc["meshes"][0]["name"].String() need no checks.
+class JsonValue
+{
+public:
+    enum Type { NullValue, BoolValue, NumberValue, StringValue, ArrayValue, ObjectValue };
+
+    Type type = NullValue;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    // parses text; returns false (leaving a null value) on malformed input
+    static bool Parse(const std::string &text, JsonValue &result)
+    {
+        const char *cursor = text.c_str();
+        const char *end = cursor + text.size();
+        result = JsonValue();
+        if (!parseValue(cursor, end, result))
+        {
+            result = JsonValue();
+            return false;
+        }
+        skipSpace(cursor, end);
+        return cursor == end;
+    }
+
+    bool IsNull() const { return type == NullValue; }
+    bool Has(const char *key) const { return &(*this)[key] != &null(); }
+    size_t Size() const { return type == ArrayValue ? elements.size() : type == ObjectValue ? members.size() : 0; }
+
+    const JsonValue &operator[](const char *key) const
+    {
+        for (const auto &member : members)
+            if (member.first == key)
+                return member.second;
+        return null();
+    }
+
+    const JsonValue &operator[](size_t index) const
+    {
+        return index < elements.size() ? elements[index] : null();
+    }
+
+    // keeps doc[0] from being ambiguous with the key overload
+    const JsonValue &operator[](int index) const
+    {
+        return index >= 0 ? (*this)[(size_t) index] : null();
+    }
+
+    double Number(double fallback = 0.0) const { return type == NumberValue ? number : fallback; }
+    int Int(int fallback = 0) const { return type == NumberValue ? (int) number : fallback; }
+    bool Bool(bool fallback = false) const { return type == BoolValue ? boolean : fallback; }
+    const std::string &String() const { return string; }
+
+private:
+    static const JsonValue &null()
+    {
+        static const JsonValue value;
+        return value;
+    }
+
+    static void skipSpace(const char *&cursor, const char *end)
+    {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+            cursor++;
+    }
+
+    static bool literal(const char *&cursor, const char *end, const char *word)
+    {
+        size_t length = strlen(word);
+        if ((size_t) (end - cursor) < length || strncmp(cursor, word, length) != 0)
+            return false;
+        cursor += length;
+        return true;
+    }
+
+    static void appendUtf8(std::string &out, unsigned int code)
+    {
+        if (code < 0x80)
+            out += (char) code;
+        else if (code < 0x800)
+        {
+            out += (char) (0xc0 | (code >> 6));
+            out += (char) (0x80 | (code & 0x3f));
+        }
+        else
+        {
+            out += (char) (0xe0 | (code >> 12));
+            out += (char) (0x80 | ((code >> 6) & 0x3f));
+            out += (char) (0x80 | (code & 0x3f));
+        }
+    }
+
+    static bool parseString(const char *&cursor, const char *end, std::string &out)
+    {
+        cursor++;   // opening quote
+        while (cursor < end && *cursor != '"')
+        {
+            char c = *cursor++;
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (cursor >= end)
+                return false;
+            char escape = *cursor++;
+            switch (escape)
+            {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u':
+                {
+                    if (end - cursor < 4)
+                        return false;
+                    appendUtf8(out, (unsigned int) strtoul(std::string(cursor, 4).c_str(), nullptr, 16));
+                    cursor += 4;
+                    break;
+                }
+                default: out += escape; break;
+            }
+        }
+        if (cursor >= end)
+            return false;
+        cursor++;   // closing quote
+        return true;
+    }
+
+    static bool parseValue(const char *&cursor, const char *end, JsonValue &value)
+    {
+        skipSpace(cursor, end);
+        if (cursor >= end)
+            return false;
+        switch (*cursor)
+        {
+            case '{':
+            {
+                value.type = ObjectValue;
+                cursor++;
+                skipSpace(cursor, end);
+                if (cursor < end && *cursor == '}')
+                {
+                    cursor++;
+                    return true;
+                }
+                while (true)
+                {
+                    skipSpace(cursor, end);
+                    std::pair<std::string, JsonValue> member;
+                    if (cursor >= end || *cursor != '"' || !parseString(cursor, end, member.first))
+                        return false;
+                    skipSpace(cursor, end);
+                    if (cursor >= end || *cursor++ != ':' || !parseValue(cursor, end, member.second))
+                        return false;
+                    value.members.push_back(std::move(member));
+                    skipSpace(cursor, end);
+                    if (cursor < end && *cursor == ',')
+                    {
+                        cursor++;
+                        continue;
+                    }
+                    return cursor < end && *cursor++ == '}';
+                }
+            }
+            case '[':
+            {
+                value.type = ArrayValue;
+                cursor++;
+                skipSpace(cursor, end);
+                if (cursor < end && *cursor == ']')
+                {
+                    cursor++;
+                    return true;
+                }
+                while (true)
+                {
+                    value.elements.emplace_back();
+                    if (!parseValue(cursor, end, value.elements.back()))
+                        return false;
+                    skipSpace(cursor, end);
+                    if (cursor < end && *cursor == ',')
+                    {
+                        cursor++;
+                        continue;
+                    }
+                    return cursor < end && *cursor++ == ']';
+                }
+            }
+            case '"':
+                value.type = StringValue;
+                return parseString(cursor, end, value.string);
+            case 't':
+                value.type = BoolValue;
+                value.boolean = true;
+                return literal(cursor, end, "true");
+            case 'f':
+                value.type = BoolValue;
+                return literal(cursor, end, "false");
+            case 'n':
+                return literal(cursor, end, "null");
+            default:
+            {
+                char *numberEnd;
+                value.type = NumberValue;
+                value.number = strtod(cursor, &numberEnd);
+                if (numberEnd == cursor)
+                    return false;
+                cursor = numberEnd;
+                return true;
+            }
+        }
+    }
+};
+#endif
@@ -0,0 +1,323 @@
+#ifndef LOAD_PROFILER_H
+#define LOAD_PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Process-wide breakdown of where startup time goes, per asset and load phase. Loaders time each phase with a Scope on a
+// monotonic clock and attach the bytes it handled; the VirtualFileSystem records every file it opens together with how much
+// of it was already in the page cache, which tells a cold run from a warm one.
+//
+//     LoadProfiler::Instance().Begin();
+//     ... load ...
+//     LoadProfiler::Instance().Finish(FileSystem::getPath("startup"));   // writes startup-cold.* or startup-warm.*
+//
+// Phases on loader threads overlap, so per-asset totals can add up to more than the wall time. GL phases measure the time
+// the calls take on the GL thread; drivers may defer the actual work unless SyncGL() makes every GL phase wait for it.
+// Thread-safe; recording stops with Finish().
+class LoadProfiler
+{
+public:
+    enum Phase {
+        Read,       // opening, mapping or decompressing the file
+        Parse,      // turning the file into meshes (native loaders) or an aiScene (ASSIMP)
+        Convert,    // aiScene to meshes, packing meshes into the shader's vertex layout
+        Optimize,   // welding and vertex cache / overdraw / fetch optimization
+        Cache,      // reading or writing the mesh cache entry
+        Decode,     // reading the cooked texture, or decoding the image and cooking it
+        Upload,     // glBufferData, glTexImage2D and friends
+        Mipmap,     // building the mip chain on a loader thread, or glGenerateMipmap
+        Compile,    // glCompileShader
+        Link,       // glLinkProgram
+        PhaseCount
+    };
+
+    // assets of a run in which less than this share of the bytes read was in the page cache count as a cold start
+    static constexpr double ColdThreshold = 0.5;
+
+    static const char *PhaseName(Phase phase)
+    {
+        static const char *names[PhaseCount] = {"read", "parse", "convert", "optimize", "cache", "decode", "upload", "mipmap",
+                                                "compile", "link"};
+        return names[phase];
+    }
+
+    static LoadProfiler &Instance()
+    {
+        static LoadProfiler profiler;
+        return profiler;
+    }
+
+    // times one phase of loading asset from construction to destruction
+    class Scope
+    {
+    public:
+        Scope(const std::string &asset, Phase phase, size_t bytes = 0, bool gl = false)
+                : asset(asset), phase(phase), bytes(bytes), gl(gl), active(Instance().Enabled())
+        {
+            if (active)
+                start = std::chrono::steady_clock::now();
+        }
+
+        ~Scope()
+        {
+            if (!active)
+                return;
+            if (gl)
+                Instance().syncGL();
+            Instance().Add(asset, phase, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                           bytes);
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        // bytes handled, when they are only known once the phase is done
+        void Bytes(size_t handled) { bytes = handled; }
+
+    private:
+        std::string asset;
+        Phase phase;
+        size_t bytes;
+        bool gl;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // clears everything recorded so far and restarts the wall clock; call first thing at startup
+    void Begin()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assets.clear();
+        start = std::chrono::steady_clock::now();
+        firstFrame = -1.0;
+        enabled = true;
+    }
+
+    bool Enabled() const { return enabled; }
+
+    // marks the first presented frame; the report gives the time to it alongside the time until everything was loaded
+    void FirstFrame()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (enabled && firstFrame < 0.0)
+            firstFrame = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // makes GL phases call finish (glFinish) before they stop their timer, so deferred driver work is attributed to them
+    void SyncGL(std::function<void()> finish)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sync = std::move(finish);
+    }
+
+    void Add(const std::string &asset, Phase phase, double milliseconds, size_t bytes = 0)
+    {
+        if (!enabled)
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        Sample &sample = assets[asset].phases[phase];
+        sample.milliseconds += milliseconds;
+        sample.bytes += bytes;
+        sample.count++;
+    }
+
+    // a file read of bytes, of which residentBytes were in the page cache before it was opened
+    void AddFile(const std::string &path, double milliseconds, size_t bytes, size_t residentBytes)
+    {
+        if (!enabled)
+            return;
+        Add(path, Read, milliseconds, bytes);
+        std::lock_guard<std::mutex> lock(mutex);
+        assets[path].fileBytes += bytes;
+        assets[path].residentBytes += residentBytes;
+    }
+
+    // stops recording, prints the report and writes it to <basePath>-cold.txt/.json or <basePath>-warm.txt/.json, so the
+    // latest run of each kind is kept for comparison. Drop the page cache (echo 3 > /proc/sys/vm/drop_caches) for a cold run.
+    void Finish(const std::string &basePath, size_t slowest = 5)
+    {
+        enabled = false;
+        std::lock_guard<std::mutex> lock(mutex);
+        double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        AssetList sorted;
+        for (const auto &asset : assets)
+            sorted.push_back(&asset);
+        std::sort(sorted.begin(), sorted.end(), [](const AssetEntry *a, const AssetEntry *b) {
+            return a->second.Total() > b->second.Total();
+        });
+        size_t fileBytes = 0, residentBytes = 0;
+        Sample totals[PhaseCount];
+        for (const auto &asset : assets)
+        {
+            fileBytes += asset.second.fileBytes;
+            residentBytes += asset.second.residentBytes;
+            for (int phase = 0; phase < PhaseCount; phase++)
+            {
+                totals[phase].milliseconds += asset.second.phases[phase].milliseconds;
+                totals[phase].bytes += asset.second.phases[phase].bytes;
+                totals[phase].count += asset.second.phases[phase].count;
+            }
+        }
+        bool cold = fileBytes > 0 && residentBytes < fileBytes * ColdThreshold;
+        std::string path = basePath + (cold ? "-cold" : "-warm");
+
+        std::ofstream text(path + ".txt", std::ios::trunc);
+        writeText(text, sorted, totals, wall, cold, fileBytes, residentBytes, slowest);
+        writeText(std::cout, sorted, totals, wall, cold, fileBytes, residentBytes, slowest);
+        std::ofstream json(path + ".json", std::ios::trunc);
+        writeJson(json, sorted, totals, wall, cold, fileBytes, residentBytes, slowest);
+        if (!text || !json)
+            std::cout << "ERROR::LOAD_PROFILER:: could not write " << path << ".txt/.json" << std::endl;
+    }
+
+private:
+    struct Sample {
+        double milliseconds = 0.0;
+        size_t bytes = 0;
+        unsigned int count = 0;
+    };
+
+    struct Asset {
+        Sample phases[PhaseCount];
+        size_t fileBytes = 0;
+        size_t residentBytes = 0;
+
+        double Total() const
+        {
+            double total = 0.0;
+            for (const Sample &sample : phases)
+                total += sample.milliseconds;
+            return total;
+        }
+    };
+
+    typedef std::pair<const std::string, Asset> AssetEntry;
+    typedef std::vector<const AssetEntry *> AssetList;
+
+    LoadProfiler() : start(std::chrono::steady_clock::now()) {}
+
+    void syncGL()
+    {
+        std::function<void()> finish;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finish = sync;
+        }
+        if (finish)
+            finish();
+    }
+
+    static std::string megabytes(size_t bytes)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%.2f MiB", bytes / (1024.0 * 1024.0));
+        return text;
+    }
+
+    static std::string milliseconds(double value, const char *format = "%9.2f ms")
+    {
+        char text[32];
+        snprintf(text, sizeof(text), format, value);
+        return text;
+    }
+
+    static std::string quoted(const std::string &text)
+    {
+        std::string result = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result + "\"";
+    }
+
+    void writeText(std::ostream &out, const AssetList &sorted, const Sample *totals, double wall, bool cold,
+                          size_t fileBytes, size_t residentBytes, size_t slowest) const
+    {
+        if (firstFrame >= 0.0)
+            out << "STARTUP:: first frame after " << milliseconds(firstFrame, "%.1f ms") << std::endl;
+        out << "STARTUP:: everything loaded after " << milliseconds(wall, "%.1f ms") << ", " << (cold ? "cold" : "warm")
+            << " page cache: " << megabytes(residentBytes) << " of " << megabytes(fileBytes) << " read was resident" << std::endl;
+        out << "STARTUP:: by phase (summed over threads):" << std::endl;
+        for (int phase = 0; phase < PhaseCount; phase++)
+            if (totals[phase].count > 0)
+                out << "  " << milliseconds(totals[phase].milliseconds) << "  " << PhaseName((Phase) phase) << " x"
+                    << totals[phase].count << ", " << megabytes(totals[phase].bytes) << std::endl;
+        out << "STARTUP:: by asset, slowest first (* = " << slowest << " slowest):" << std::endl;
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            const Asset &asset = sorted[i]->second;
+            out << (i < slowest ? "* " : "  ") << milliseconds(asset.Total()) << "  " << sorted[i]->first;
+            if (asset.fileBytes > 0)
+                out << " (" << asset.residentBytes * 100 / asset.fileBytes << "% cached)";
+            out << std::endl << "               ";
+            for (int phase = 0; phase < PhaseCount; phase++)
+                if (asset.phases[phase].count > 0)
+                    out << "  " << PhaseName((Phase) phase) << " " << milliseconds(asset.phases[phase].milliseconds, "%.2f ms")
+                        << " / " << megabytes(asset.phases[phase].bytes);
+            out << std::endl;
+        }
+    }
+
+    static void writeSample(std::ostream &out, const Sample &sample)
+    {
+        out << "{\"milliseconds\": " << sample.milliseconds << ", \"bytes\": " << sample.bytes << ", \"count\": " << sample.count << "}";
+    }
+
+    // one object per asset with per-phase samples, ready for sorting with e.g. jq 'sort_by(-.phases.decode.milliseconds)'
+    void writeJson(std::ostream &out, const AssetList &sorted, const Sample *totals, double wall, bool cold,
+                          size_t fileBytes, size_t residentBytes, size_t slowest) const
+    {
+        out << "{\n  \"run\": \"" << (cold ? "cold" : "warm") << "\",\n  \"firstFrameMilliseconds\": " << firstFrame
+            << ",\n  \"wallMilliseconds\": " << wall
+            << ",\n  \"fileBytes\": " << fileBytes << ",\n  \"residentBytes\": " << residentBytes << ",\n  \"phases\": {";
+        const char *separator = "";
+        for (int phase = 0; phase < PhaseCount; phase++)
+        {
+            out << separator << "\n    \"" << PhaseName((Phase) phase) << "\": ";
+            writeSample(out, totals[phase]);
+            separator = ",";
+        }
+        out << "\n  },\n  \"assets\": [";
+        separator = "";
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            const Asset &asset = sorted[i]->second;
+            out << separator << "\n    {\"path\": " << quoted(sorted[i]->first) << ", \"totalMilliseconds\": " << asset.Total()
+                << ", \"slow\": " << (i < slowest ? "true" : "false") << ", \"fileBytes\": " << asset.fileBytes
+                << ", \"residentBytes\": " << asset.residentBytes << ", \"phases\": {";
+            const char *phaseSeparator = "";
+            for (int phase = 0; phase < PhaseCount; phase++)
+            {
+                if (asset.phases[phase].count == 0)
+                    continue;
+                out << phaseSeparator << "\"" << PhaseName((Phase) phase) << "\": ";
+                writeSample(out, asset.phases[phase]);
+                phaseSeparator = ", ";
+            }
+            out << "}}";
+            separator = ",";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    std::mutex mutex;
+    std::map<std::string, Asset> assets;
+    std::chrono::steady_clock::time_point start;
+    double firstFrame = -1.0;   // milliseconds from Begin(), negative until FirstFrame()
+    std::atomic<bool> enabled{false};
+    std::function<void()> sync;
+};
+#endif
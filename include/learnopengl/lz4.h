@@ -0,0 +1,130 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// LZ4 block format (no frame header), compatible with the reference implementation: a sequence is a token with the
+// literal and match lengths in its high and low nibble, the literals, a 16-bit little-endian match offset and length
+// extension bytes. The compressor is the greedy single-probe variant, fast enough for packing; the decompressor checks
+// every length and offset, so corrupt input fails instead of reading or writing out of bounds.
+namespace LZ4
+{
+    static const size_t MinMatch = 4;
+    static const size_t LastLiterals = 5;     // the block always ends with at least this many literals
+    static const size_t MatchLimit = 12;      // and its last match starts at least this far from the end
+    static const int HashLog = 16;
+
+    inline size_t CompressBound(size_t size) { return size + size / 255 + 16; }
+
+    inline void writeLength(unsigned char *&out, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+            *out++ = 255;
+        *out++ = (unsigned char) length;
+    }
+
+    // compresses size bytes of src into out; returns false when the result would not be smaller than the input
+    inline bool Compress(const unsigned char *src, size_t size, std::vector<unsigned char> &out)
+    {
+        out.resize(CompressBound(size));
+        unsigned char *dst = out.data();
+        std::vector<uint32_t> table((size_t) 1 << HashLog, 0);
+        size_t anchor = 0;
+        auto emit = [&](size_t literalEnd, size_t offset, size_t matchLength) {
+            size_t literals = literalEnd - anchor;
+            unsigned char *token = dst++;
+            *token = (unsigned char) ((literals >= 15 ? 15 : literals) << 4);
+            if (literals >= 15)
+                writeLength(dst, literals - 15);
+            memcpy(dst, src + anchor, literals);
+            dst += literals;
+            if (matchLength == 0)
+                return;
+            *dst++ = (unsigned char) (offset & 0xff);
+            *dst++ = (unsigned char) (offset >> 8);
+            size_t extra = matchLength - MinMatch;
+            *token |= (unsigned char) (extra >= 15 ? 15 : extra);
+            if (extra >= 15)
+                writeLength(dst, extra - 15);
+        };
+
+        if (size > MatchLimit)
+        {
+            size_t limit = size - MatchLimit;
+            for (size_t i = 0; i < limit;)
+            {
+                uint32_t sequence;
+                memcpy(&sequence, src + i, 4);
+                uint32_t &slot = table[(sequence * 2654435761u) >> (32 - HashLog)];
+                size_t candidate = slot;
+                slot = (uint32_t) i;
+                uint32_t previous;
+                memcpy(&previous, src + candidate, 4);
+                if (candidate >= i || i - candidate > 65535 || previous != sequence)
+                {
+                    i++;
+                    continue;
+                }
+                size_t length = MinMatch;
+                while (i + length < size - LastLiterals && src[candidate + length] == src[i + length])
+                    length++;
+                emit(i, i - candidate, length);
+                i += length;
+                anchor = i;
+            }
+        }
+        emit(size, 0, 0);
+        out.resize(dst - out.data());
+        return out.size() < size;
+    }
+
+    // decompresses a block into exactly rawSize bytes at dst; false on malformed input
+    inline bool Decompress(const unsigned char *src, size_t size, unsigned char *dst, size_t rawSize)
+    {
+        size_t in = 0, out = 0;
+        auto readLength = [&](size_t &length) {
+            unsigned char byte;
+            do
+            {
+                if (in >= size)
+                    return false;
+                byte = src[in++];
+                length += byte;
+            } while (byte == 255);
+            return true;
+        };
+        while (in < size)
+        {
+            unsigned char token = src[in++];
+            size_t literals = token >> 4;
+            if (literals == 15 && !readLength(literals))
+                return false;
+            if (literals > size - in || literals > rawSize - out)
+                return false;
+            memcpy(dst + out, src + in, literals);
+            in += literals;
+            out += literals;
+            if (in == size)
+                break;      // the last sequence has no match
+
+            if (size - in < 2)
+                return false;
+            size_t offset = src[in] | (src[in + 1] << 8);
+            in += 2;
+            size_t length = token & 15;
+            if (length == 15 && !readLength(length))
+                return false;
+            length += MinMatch;
+            if (offset == 0 || offset > out || length > rawSize - out)
+                return false;
+            // byte by byte, since the match may overlap the bytes it produces
+            for (size_t i = 0; i < length; i++, out++)
+                dst[out] = dst[out - offset];
+        }
+        return out == rawSize;
+    }
+}
+#endif
@@ -0,0 +1,76 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// read-only memory mapping of a whole file, unmapped on destruction
+class MappedFile
+{
+public:
+    MappedFile() {}
+    explicit MappedFile(const std::string &path) { Open(path); }
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool Open(const std::string &path)
+    {
+        Close();
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED)
+            {
+                data = static_cast<const unsigned char *>(mapping);
+                size = st.st_size;
+            }
+        }
+        close(fd);
+        return data != nullptr;
+    }
+
+    void Close()
+    {
+        if (data)
+            munmap(const_cast<unsigned char *>(data), size);
+        data = nullptr;
+        size = 0;
+    }
+
+    bool IsOpen() const { return data != nullptr; }
+
+    // bytes of [data, data + size) inside a file mapping that are in the page cache, i.e. readable without disk I/O
+    static size_t ResidentBytes(const unsigned char *data, size_t size)
+    {
+        if (!data || size == 0)
+            return 0;
+        size_t page = (size_t) sysconf(_SC_PAGESIZE);
+        uintptr_t first = (uintptr_t) data / page * page;
+        size_t pages = ((uintptr_t) data + size - first + page - 1) / page;
+        std::vector<unsigned char> resident(pages);
+        if (mincore(reinterpret_cast<void *>(first), pages * page, resident.data()) != 0)
+            return 0;
+        size_t count = 0;
+        for (unsigned char flags : resident)
+            count += flags & 1;
+        return std::min(count * page, size);
+    }
+
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+};
+#endif
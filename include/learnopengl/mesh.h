@@ -6,33 +6,62 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/geometry_buffer.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/vertex_format.h>
 
 #include <string>
 #include <vector>
 using namespace std;
 
-struct Vertex {
-    // position
-    glm::vec3 Position;
-    // normal
-    glm::vec3 Normal;
-    // texCoords
-    glm::vec2 TexCoords;
-    // tangent
-    glm::vec3 Tangent;
-    // bitangent
-    glm::vec3 Bitangent;
-};
-
-
-
 struct Texture {
     unsigned int id;
     string type;
     string path;
 };
 
+// texture used by a mesh before it is loaded: sampler type and path relative to the model directory
+struct TextureRef {
+    string type;
+    string path;
+};
+
+// CPU-side result of importing one mesh. Geometry is either owned by the vectors or borrowed from external storage
+// (e.g. a mapped mesh cache entry) through the view pointers; use VertexData()/IndexData() to read it either way.
+struct MeshData {
+    vector<Vertex>       vertices;
+    vector<unsigned int> indices;
+    const Vertex       *vertexView = nullptr;
+    const unsigned int *indexView = nullptr;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    vector<TextureRef> textures;
+    int node = -1;              // kept node the mesh is baked relative to, or -1 for the model itself (see NodeHierarchy)
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    PackedGeometry packed;      // filled by Pack() off the GL thread; Mesh packs for the default layout otherwise
+
+    const Vertex *VertexData() const { return vertices.empty() ? vertexView : vertices.data(); }
+    const unsigned int *IndexData() const { return indices.empty() ? indexView : indices.data(); }
+    size_t VertexCount() const { return vertices.empty() ? vertexCount : vertices.size(); }
+    size_t IndexCount() const { return indices.empty() ? indexCount : indices.size(); }
+
+    void ComputeBounds()
+    {
+        boundsMin = boundsMax = VertexCount() == 0 ? glm::vec3(0.0f) : VertexData()[0].Position;
+        for (size_t i = 0; i < VertexCount(); i++)
+        {
+            boundsMin = glm::min(boundsMin, VertexData()[i].Position);
+            boundsMax = glm::max(boundsMax, VertexData()[i].Position);
+        }
+    }
+
+    void Pack(const VertexLayout &layout)
+    {
+        packed = PackedGeometry::Pack(VertexData(), VertexCount(), IndexData(), IndexCount(), layout, boundsMin, boundsMax);
+    }
+};
+
 class Mesh {
 public:
     // mesh Data
@@ -40,33 +69,81 @@ public:
     vector<unsigned int> indices;
     vector<Texture>      textures;
 
-    unsigned int VAO;
+    GeometryRange geometry;     // suballocated from the shared pool of its vertex format, returned when the mesh is destroyed
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    glm::vec3 positionOffset;   // dequantization of the packed positions, see VertexLayout
+    glm::vec3 positionScale;
+    int node = -1;              // see MeshData::node
     std::string glslIdentifierPrefix;
+    vector<UniformId> samplers;     // glslIdentifierPrefix + type + N for each texture, see SetTexturePrefix
     // constructor
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
+        computeBounds();
+        SetTexturePrefix("");
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(PackedGeometry::Pack(this->vertices.data(), this->vertices.size(), this->indices.data(), this->indices.size(),
+                                       VertexLayout(), boundsMin, boundsMax));
+    }
+
+    // constructs a mesh from imported data, uploading the streams packed by the importer; owned geometry is moved in
+    // unless keepGeometry is false, borrowed geometry is never copied to the CPU side
+    Mesh(MeshData &&data, vector<Texture> textures, bool keepGeometry = true)
+    {
+        if (data.packed.Empty())
+            data.Pack(VertexLayout());
+        if (keepGeometry)
+        {
+            this->vertices = std::move(data.vertices);
+            this->indices = std::move(data.indices);
+        }
+        this->textures = std::move(textures);
+        SetTexturePrefix("");
+        this->node = data.node;
+        this->boundsMin = data.boundsMin;
+        this->boundsMax = data.boundsMax;
+        setupMesh(data.packed);
+    }
+
+    // the GPU copy is owned through geometry, so a mesh can be moved but not copied
+    Mesh(Mesh &&) = default;
+    Mesh &operator=(Mesh &&) = default;
+
+    // drops the CPU copy of the geometry; drawing only needs the uploaded streams
+    void ReleaseGeometry()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
     }
 
     // render the mesh
     void Draw(Shader &shader)
     {
-        // bind appropriate textures
+        glBindVertexArray(geometry.pool->VertexArray());
+        DrawBound(shader);
+        glBindVertexArray(0);
+    }
+
+    // names the samplers prefix + texture_diffuseN etc., N counting from 1 per texture type; hashed once here rather than
+    // on every draw
+    void SetTexturePrefix(const std::string &prefix)
+    {
+        glslIdentifierPrefix = prefix;
+        samplers.clear();
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
+        for (const Texture &texture : textures)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
-            string name = textures[i].type;
+            const string &name = texture.type;
             if(name == "texture_diffuse")
                 number = std::to_string(diffuseNr++);
             else if(name == "texture_specular")
@@ -75,65 +152,53 @@ public:
                 number = std::to_string(normalNr++); // transfer unsigned int to stream
             else if(name == "texture_height")
                 number = std::to_string(heightNr++); // transfer unsigned int to stream
+            samplers.push_back(UniformId(prefix + name + number));
+        }
+    }
 
+    // render the mesh with the VAO of its geometry pool already bound, so consecutive meshes of a pool skip the rebind
+    void DrawBound(Shader &shader)
+    {
+        // bind appropriate textures
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (glslIdentifierPrefix + name + number).c_str()), i);
+            shader.setInt(samplers[i], i);
             // and finally bind the texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
 
-
+        static constexpr UniformId PositionOffset("positionOffset");
+        static constexpr UniformId PositionScale("positionScale");
+        shader.setVec3(PositionOffset, positionOffset);
+        shader.setVec3(PositionScale, positionScale);
 
         // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei) geometry.indexCount, geometry.indexType, (void *) geometry.indexOffset,
+                                 (GLint) geometry.baseVertex);
 
         // always good practice to set everything back to defaults once configured.
         glActiveTexture(GL_TEXTURE0);
     }
 
 private:
-    // render data
-    unsigned int VBO, EBO;
-
-    // initializes all the buffer objects/arrays
-    void setupMesh()
+    void computeBounds()
     {
-        // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+        boundsMin = boundsMax = vertices.empty() ? glm::vec3(0.0f) : vertices[0].Position;
+        for (const Vertex &vertex : vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.Position);
+            boundsMax = glm::max(boundsMax, vertex.Position);
+        }
+    }
 
-        glBindVertexArray(0);
+    // copies the packed streams into the shared geometry buffers
+    void setupMesh(const PackedGeometry &packed)
+    {
+        this->positionOffset = packed.positionOffset;
+        this->positionScale = packed.positionScale;
+        geometry = GeometryBuffers::Instance().Allocate(packed);
     }
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef MESH_ATTRIBUTES_H
+#define MESH_ATTRIBUTES_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/vertex_format.h>
+
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Vertex attributes derived from the geometry, for importers whose source files leave them out (what ASSIMP's
+// aiProcess_GenNormals, aiProcess_GenSmoothNormals and aiProcess_CalcTangentSpace do for the ASSIMP path).
+namespace MeshAttributes
+{
+    inline glm::vec3 SafeNormalize(const glm::vec3 &v)
+    {
+        float length = std::sqrt(glm::dot(v, v));
+        return length > 0.0f ? v / length : v;
+    }
+
+    // area-weighted sum of the adjacent face normals, shared by all vertices at the same position so UV seams stay smooth
+    inline void GenerateSmoothNormals(std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices)
+    {
+        struct PositionHash {
+            size_t operator()(const glm::vec3 &p) const
+            {
+                return std::hash<float>()(p.x) ^ (std::hash<float>()(p.y) * 31) ^ (std::hash<float>()(p.z) * 961);
+            }
+        };
+        struct PositionEqual {
+            bool operator()(const glm::vec3 &a, const glm::vec3 &b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+        };
+        std::unordered_map<glm::vec3, unsigned int, PositionHash, PositionEqual> positions;
+        std::vector<unsigned int> group(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            group[i] = positions.emplace(vertices[i].Position, (unsigned int) positions.size()).first->second;
+
+        std::vector<glm::vec3> normals(positions.size(), glm::vec3(0.0f));
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            const glm::vec3 &a = vertices[indices[t]].Position, &b = vertices[indices[t + 1]].Position,
+                            &c = vertices[indices[t + 2]].Position;
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            for (int corner = 0; corner < 3; corner++)
+                normals[group[indices[t + corner]]] += normal;
+        }
+        for (size_t i = 0; i < vertices.size(); i++)
+            vertices[i].Normal = SafeNormalize(normals[group[i]]);
+    }
+
+    // gives every triangle its own vertices so each can carry the face normal
+    inline void GenerateFlatNormals(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+        std::vector<Vertex> faceted;
+        faceted.reserve(indices.size());
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            Vertex a = vertices[indices[t]], b = vertices[indices[t + 1]], c = vertices[indices[t + 2]];
+            glm::vec3 normal = SafeNormalize(glm::cross(b.Position - a.Position, c.Position - a.Position));
+            a.Normal = b.Normal = c.Normal = normal;
+            faceted.push_back(a);
+            faceted.push_back(b);
+            faceted.push_back(c);
+        }
+        vertices.swap(faceted);
+        for (size_t i = 0; i < indices.size(); i++)
+            indices[i] = (unsigned int) i;
+    }
+
+    // per-vertex tangent frame from the UV gradients of the adjacent triangles
+    inline void GenerateTangents(std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices)
+    {
+        for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        {
+            Vertex &a = vertices[indices[t]], &b = vertices[indices[t + 1]], &c = vertices[indices[t + 2]];
+            glm::vec3 edge1 = b.Position - a.Position, edge2 = c.Position - a.Position;
+            glm::vec2 uv1 = b.TexCoords - a.TexCoords, uv2 = c.TexCoords - a.TexCoords;
+            float determinant = uv1.x * uv2.y - uv2.x * uv1.y;
+            if (std::fabs(determinant) < 1e-12f)
+                continue;
+            float r = 1.0f / determinant;
+            glm::vec3 tangent = (edge1 * uv2.y - edge2 * uv1.y) * r;
+            glm::vec3 bitangent = (edge2 * uv1.x - edge1 * uv2.x) * r;
+            for (Vertex *vertex : {&a, &b, &c})
+            {
+                vertex->Tangent += tangent;
+                vertex->Bitangent += bitangent;
+            }
+        }
+        for (Vertex &vertex : vertices)
+        {
+            // Gram-Schmidt against the normal
+            vertex.Tangent = SafeNormalize(vertex.Tangent - vertex.Normal * glm::dot(vertex.Normal, vertex.Tangent));
+            vertex.Bitangent = SafeNormalize(vertex.Bitangent);
+        }
+    }
+
+    // bakes a node transform into the vertices; a mirroring transform also reverses the winding so front faces stay front
+    inline void Transform(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, const glm::mat4 &matrix)
+    {
+        glm::mat3 linear(matrix);
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+        for (Vertex &vertex : vertices)
+        {
+            vertex.Position = glm::vec3(matrix * glm::vec4(vertex.Position, 1.0f));
+            vertex.Normal = SafeNormalize(normalMatrix * vertex.Normal);
+            vertex.Tangent = SafeNormalize(linear * vertex.Tangent);
+            vertex.Bitangent = SafeNormalize(linear * vertex.Bitangent);
+        }
+        if (glm::determinant(linear) < 0.0f)
+            for (size_t t = 0; t + 2 < indices.size(); t += 3)
+                std::swap(indices[t + 1], indices[t + 2]);
+    }
+}
+#endif
@@ -0,0 +1,322 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/hash.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/node_hierarchy.h>
+#include <learnopengl/virtual_file_system.h>
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// content hash of a model file plus the companion files it pulls in by name (scene.gltf -> scene.bin,
+// untitled.obj -> untitled.mtl)
+inline uint64_t HashModelSource(const std::string &path)
+{
+    uint64_t hash = 14695981039346656037ull;
+    std::string stem = path.substr(0, path.find_last_of('.'));
+    const std::string files[] = {path, stem + ".bin", stem + ".mtl"};
+    bool found = false;
+    for (const std::string &file : files)
+    {
+        FileView source = VirtualFileSystem::Instance().Open(file);
+        if (!source)
+            continue;
+        hash = HashContent(source.data, source.size, hash);
+        found = true;
+    }
+    return found ? hash : 0;
+}
+
+// Versioned binary cache of imported models. One file per source model and import profile under resources/cache holds
+// the final Vertex and index arrays, texture references and bounds, and the kept nodes of the model, keyed by the
+// source content hash and the profile it was built with. Entries whose key no longer matches are rejected on read and
+// rewritten by the caller after a fresh import.
+class MeshCache
+{
+public:
+    static const uint32_t Version = 4;
+
+    static std::string CacheDirectory() { return "resources/cache"; }
+
+    static std::string EntryPath(const std::string &sourcePath, uint64_t profileKey)
+    {
+        std::string name = sourcePath.substr(sourcePath.find_last_of('/') + 1);
+        char hash[34];
+        snprintf(hash, sizeof(hash), "%016llx-%016llx",
+                 (unsigned long long) HashBytes(sourcePath.data(), sourcePath.size()), (unsigned long long) profileKey);
+        return CacheDirectory() + "/" + name + "-" + hash + ".hkmesh";
+    }
+
+    // maps the cache entry for sourcePath under the import profile identified by profileKey and validates it against
+    // the current source hash and its own index ranges. The resulting meshes borrow their geometry from the mapping, so
+    // the cache must outlive their upload. An entry in the resource pack is preferred; when it is stale, one rewritten
+    // on disk since the pack was built is used.
+    bool Open(const std::string &sourcePath, uint64_t sourceHash, uint64_t profileKey)
+    {
+        if (sourceHash == 0)
+            return false;
+        std::string path = EntryPath(sourcePath, profileKey);
+        const VirtualFileSystem &files = VirtualFileSystem::Instance();
+        return read(files.Open(path), sourceHash, profileKey)
+               || (files.Packed(path) && read(files.OpenLoose(path), sourceHash, profileKey));
+    }
+
+    // serializes meshes into a fresh cache entry; written to a temporary file and renamed so readers never see a
+    // partial entry
+    static bool Write(const std::string &sourcePath, uint64_t sourceHash, uint64_t profileKey,
+                      const std::vector<MeshData> &meshes, const NodeHierarchy &nodes)
+    {
+        if (sourceHash == 0)
+            return false;
+        mkdir("resources", 0755);
+        mkdir(CacheDirectory().c_str(), 0755);
+
+        std::string entryPath = EntryPath(sourcePath, profileKey);
+        std::string tempPath = entryPath + ".tmp";
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "ERROR::MESH_CACHE:: could not write " << tempPath << std::endl;
+            return false;
+        }
+
+        Header header = {};
+        memcpy(header.magic, "HKMC", 4);
+        header.version = Version;
+        header.meshCount = (uint32_t) meshes.size();
+        header.nodeCount = (uint32_t) nodes.Count();
+        header.sourceHash = sourceHash;
+        header.profileKey = profileKey;
+        glm::vec3 modelMin(0.0f), modelMax(0.0f);
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            modelMin = i == 0 ? meshes[i].boundsMin : glm::min(modelMin, meshes[i].boundsMin);
+            modelMax = i == 0 ? meshes[i].boundsMax : glm::max(modelMax, meshes[i].boundsMax);
+        }
+        storeVec3(header.boundsMin, modelMin);
+        storeVec3(header.boundsMax, modelMax);
+        size_t offset = 0;
+        put(out, offset, &header, sizeof(header));
+
+        for (int i = 0; i < nodes.Count(); i++)
+        {
+            NodeRecord record = {};
+            record.parent = nodes.Parent(i);
+            memcpy(record.local, &nodes.Local(i)[0][0], sizeof(record.local));
+            put(out, offset, &record, sizeof(record));
+            putString(out, offset, nodes.Name(i));
+            static const char zeros[4] = {0, 0, 0, 0};
+            put(out, offset, zeros, (4 - offset % 4) % 4);
+        }
+
+        for (const MeshData &mesh : meshes)
+        {
+            MeshRecord record = {};
+            record.vertexCount = (uint32_t) mesh.VertexCount();
+            record.indexCount = (uint32_t) mesh.IndexCount();
+            record.textureCount = (uint32_t) mesh.textures.size();
+            record.node = mesh.node;
+            storeVec3(record.boundsMin, mesh.boundsMin);
+            storeVec3(record.boundsMax, mesh.boundsMax);
+            put(out, offset, &record, sizeof(record));
+            for (const TextureRef &texture : mesh.textures)
+            {
+                putString(out, offset, texture.type);
+                putString(out, offset, texture.path);
+            }
+            static const char zeros[4] = {0, 0, 0, 0};
+            put(out, offset, zeros, (4 - offset % 4) % 4);
+            put(out, offset, mesh.VertexData(), sizeof(Vertex) * mesh.VertexCount());
+            put(out, offset, mesh.IndexData(), sizeof(unsigned int) * mesh.IndexCount());
+        }
+        out.close();
+        if (!out || rename(tempPath.c_str(), entryPath.c_str()) != 0)
+        {
+            std::cout << "ERROR::MESH_CACHE:: could not finalize " << entryPath << std::endl;
+            remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<MeshData> meshes;
+    NodeHierarchy nodes;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+private:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t meshCount;
+        uint32_t nodeCount;
+        uint64_t sourceHash;
+        uint64_t profileKey;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct MeshRecord {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t textureCount;
+        int32_t node;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    // followed by the node name and padding to 4 bytes; parents precede their children
+    struct NodeRecord {
+        int32_t parent;
+        float local[16];
+    };
+
+    // bounds-checked cursor over the mapping
+    struct Reader {
+        const unsigned char *begin;
+        const unsigned char *end;
+        const unsigned char *cursor = nullptr;
+
+        Reader(const unsigned char *b, const unsigned char *e) : begin(b), end(e), cursor(b) {}
+
+        const unsigned char *Skip(size_t bytes)
+        {
+            if ((size_t) (end - cursor) < bytes)
+                return nullptr;
+            const unsigned char *at = cursor;
+            cursor += bytes;
+            return at;
+        }
+        template<typename T>
+        bool Read(T &value)
+        {
+            const unsigned char *at = Skip(sizeof(T));
+            if (at)
+                memcpy(&value, at, sizeof(T));
+            return at != nullptr;
+        }
+        bool ReadString(std::string &value)
+        {
+            uint32_t length;
+            if (!Read(length))
+                return false;
+            const unsigned char *at = Skip(length);
+            if (at)
+                value.assign(reinterpret_cast<const char *>(at), length);
+            return at != nullptr;
+        }
+        void Align(size_t alignment)
+        {
+            size_t offset = cursor - begin;
+            Skip((alignment - offset % alignment) % alignment);
+        }
+    };
+
+    // parses the cache entry in view if it matches sourceHash and profileKey; keeps the view for the borrowed geometry
+    bool read(FileView view, uint64_t sourceHash, uint64_t profileKey)
+    {
+        meshes.clear();
+        nodes = NodeHierarchy();
+        if (!view)
+            return false;
+        file = std::move(view);
+        Reader reader{file.data, file.data + file.size};
+        Header header = {};
+        if (!reader.Read(header) || memcmp(header.magic, "HKMC", 4) != 0 || header.version != Version
+            || header.profileKey != profileKey || header.sourceHash != sourceHash)
+        {
+            file = FileView();
+            return false;
+        }
+
+        glm::vec3 modelMin(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+        glm::vec3 modelMax(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+        for (uint32_t i = 0; i < header.nodeCount; i++)
+        {
+            NodeRecord record = {};
+            std::string name;
+            if (!reader.Read(record) || !reader.ReadString(name))
+                return fail("truncated cache entry");
+            reader.Align(4);
+            glm::mat4 local;
+            memcpy(&local[0][0], record.local, sizeof(record.local));
+            nodes.Add(name, record.parent, local);
+        }
+        for (uint32_t i = 0; i < header.meshCount; i++)
+        {
+            MeshRecord record = {};
+            if (!reader.Read(record))
+                return fail("truncated cache entry");
+            MeshData mesh;
+            mesh.vertexCount = record.vertexCount;
+            mesh.indexCount = record.indexCount;
+            mesh.node = record.node >= 0 && record.node < nodes.Count() ? record.node : (int) NodeHierarchy::NoNode;
+            mesh.boundsMin = glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]);
+            mesh.boundsMax = glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]);
+            for (uint32_t t = 0; t < record.textureCount; t++)
+            {
+                TextureRef ref;
+                if (!reader.ReadString(ref.type) || !reader.ReadString(ref.path))
+                    return fail("truncated cache entry");
+                mesh.textures.push_back(ref);
+            }
+            reader.Align(4);
+            mesh.vertexView =
+                reinterpret_cast<const Vertex *>(reader.Skip(sizeof(Vertex) * (size_t) record.vertexCount));
+            mesh.indexView =
+                reinterpret_cast<const unsigned int *>(reader.Skip(sizeof(unsigned int) * (size_t) record.indexCount));
+            if (!mesh.vertexView || !mesh.indexView)
+                return fail("truncated cache entry");
+            // the indices go straight to the GPU, so a corrupt entry must not make it fetch past the vertices
+            for (uint32_t index = 0; index < record.indexCount; index++)
+                if (mesh.indexView[index] >= record.vertexCount)
+                    return fail("index out of range in cache entry");
+            meshes.push_back(std::move(mesh));
+        }
+        boundsMin = modelMin;
+        boundsMax = modelMax;
+        return true;
+    }
+
+    bool fail(const char *reason)
+    {
+        std::cout << "ERROR::MESH_CACHE:: " << reason << std::endl;
+        meshes.clear();
+        nodes = NodeHierarchy();
+        file = FileView();
+        return false;
+    }
+
+    static void storeVec3(float *dst, const glm::vec3 &v)
+    {
+        dst[0] = v.x;
+        dst[1] = v.y;
+        dst[2] = v.z;
+    }
+
+    static void put(std::ofstream &out, size_t &offset, const void *data, size_t size)
+    {
+        out.write(static_cast<const char *>(data), size);
+        offset += size;
+    }
+
+    static void putString(std::ofstream &out, size_t &offset, const std::string &value)
+    {
+        uint32_t length = (uint32_t) value.size();
+        put(out, offset, &length, sizeof(length));
+        put(out, offset, value.data(), value.size());
+    }
+
+    FileView file;
+};
+#endif
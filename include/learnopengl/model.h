@@ -10,146 +10,438 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/gltf_loader.h>
+#include <learnopengl/import_profile.h>
+#include <learnopengl/load_profiler.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/node_hierarchy.h>
+#include <learnopengl/obj_loader.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/thread_pool.h>
+#include <learnopengl/vfs_io_system.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
-
-
+// everything Model::Import produces off the GL thread: converted meshes and their decoded textures, keyed by relative path
+struct ModelData {
+    string path;
+    string directory;
+    vector<MeshData> meshes;
+    NodeHierarchy nodes;
+    map<string, ImageData> images;
+    shared_ptr<MeshCache> cache;    // keeps a mapped cache entry alive until the meshes borrowing from it are uploaded
+    bool keepGeometry = true;       // whether meshes keep a CPU copy of their vertices and indices after upload
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
 
 class Model
 {
 public:
     // model data
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<Texture> textures_loaded;	// stores all the textures loaded so far, each holding one reference in the TextureRegistry.
     vector<Mesh>    meshes;
+    NodeHierarchy   nodes;              // animated nodes the meshes hang from; empty for models without animation
     string directory;
     bool gammaCorrection;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    // empty model, filled later by Upload (see AssetLoader)
+    Model() : gammaCorrection(false) {}
+
+    // textures are shared through the TextureRegistry and mesh geometry through the GeometryBuffers, so a model owns
+    // references that must be released exactly once
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+    Model(Model &&) = default;
 
-    // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // releases what this model held before taking over other's references; other is left empty
+    Model &operator=(Model &&other)
     {
-        loadModel(path);
+        if (this == &other)
+            return *this;
+        Release();
+        textures_loaded = std::move(other.textures_loaded);
+        meshes = std::move(other.meshes);
+        nodes = std::move(other.nodes);
+        directory = std::move(other.directory);
+        gammaCorrection = other.gammaCorrection;
+        boundsMin = other.boundsMin;
+        boundsMax = other.boundsMax;
+        texturesByPath = std::move(other.texturesByPath);
+        shaderTextureNamePrefix = std::move(other.shaderTextureNamePrefix);
+        other.textures_loaded.clear();
+        other.texturesByPath.clear();
+        other.meshes.clear();
+        return *this;
     }
 
-    // draws the model, and thus all its meshes
+    ~Model()
+    {
+        Release();
+    }
+
+    // drops the meshes and texture references, leaving an empty model that draws nothing until it is uploaded again
+    void Release()
+    {
+        for (const Texture &texture : textures_loaded)
+            TextureRegistry::Instance().Release(texture.id);
+        textures_loaded.clear();
+        texturesByPath.clear();
+        meshes.clear();
+        nodes = NodeHierarchy();
+    }
+
+    bool Loaded() const { return !meshes.empty(); }
+
+    // constructor, expects a filepath to a 3D model and the vertex layout of the shader it is drawn with.
+    Model(string const &path, bool gamma = false, const VertexLayout &layout = VertexLayout()) : gammaCorrection(gamma)
+    {
+        ModelData data = Import(path, layout);
+        Upload(data);
+    }
+
+    // draws the model, and thus all its meshes; the VAO is only rebound where consecutive meshes use different vertex formats.
+    // Meshes below a kept node are drawn with its world matrix as nodeTransform (identity for the rest), as of the last
+    // nodes.UpdateWorld(); Shader skips the upload while consecutive meshes share one.
     void Draw(Shader &shader)
     {
+        static const glm::mat4 identity(1.0f);
+        static const glm::mat3 identityNormal(1.0f);
+        static constexpr UniformId NodeTransform("nodeTransform");
+        static constexpr UniformId NodeNormalMatrix("nodeNormalMatrix");
+        unsigned int boundVAO = 0;
         for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        {
+            if (meshes[i].geometry.pool->VertexArray() != boundVAO)
+            {
+                boundVAO = meshes[i].geometry.pool->VertexArray();
+                glBindVertexArray(boundVAO);
+            }
+            int node = meshes[i].node;
+            shader.setMat4(NodeTransform, node == NodeHierarchy::NoNode ? identity : nodes.World(node));
+            shader.setMat3(NodeNormalMatrix, node == NodeHierarchy::NoNode ? identityNormal : nodes.Normal(node));
+            meshes[i].DrawBound(shader);
+        }
+        glBindVertexArray(0);
     }
 
+    // also applies to meshes uploaded later
     void SetShaderTextureNamePrefix(std::string prefix) {
+        shaderTextureNamePrefix = prefix;
         for (Mesh& mesh: meshes) {
-            mesh.glslIdentifierPrefix = prefix;
+            mesh.SetTexturePrefix(prefix);
         }
     }
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path)
+
+    // CPU half of loading: imports the geometry (see ImportGeometry), packs the meshes into layout and decodes every
+    // referenced texture. Touches no GL state, so it can run on any thread.
+    static ModelData Import(string const &path, const VertexLayout &layout = VertexLayout())
+    {
+        ModelData data;
+        ImportGeometry(path, data);
+        // one entry per distinct image, in place before the workers fill them so the map is not modified concurrently
+        vector<pair<const TextureRef *, ImageData *>> decodes;
+        for (const MeshData &mesh : data.meshes)
+            for (const TextureRef &ref : mesh.textures)
+                if (data.images.find(ref.path) == data.images.end())
+                    decodes.emplace_back(&ref, &data.images[ref.path]);
+
+        // meshes are packed and images decoded side by side
+        ThreadPool::Instance().ParallelFor(data.meshes.size() + decodes.size(), [&data, &decodes, &path, &layout](size_t i) {
+            if (i < data.meshes.size())
+            {
+                LoadProfiler::Scope timer(path, LoadProfiler::Convert);
+                data.meshes[i].Pack(layout);
+                timer.Bytes(data.meshes[i].packed.vertices.size() + data.meshes[i].packed.indices.size());
+                return;
+            }
+            const TextureRef &ref = *decodes[i - data.meshes.size()].first;
+            ImageData &image = *decodes[i - data.meshes.size()].second;
+            // skip loading images another model already has resident; Upload picks them up from the registry
+            string canonicalPath = CanonicalPath(data.directory + '/' + ref.path);
+            TextureCompression::Usage usage = TextureUsage(ref);
+            if (!TextureRegistry::Instance().Contains(canonicalPath))
+                image = LoadTextureImage(canonicalPath, usage);
+            image.canonicalPath = canonicalPath;
+            image.normalMap = usage == TextureCompression::Normal;
+        });
+        return data;
+    }
+
+    // reads the meshes of the model from the mesh cache when it is up to date, otherwise imports them (glTF and OBJ
+    // natively, anything else with ASSIMP) as its ImportProfile says and refreshes the cache. Also run by hk_cook, which
+    // fills the cache ahead of time; returns false if the file could not be imported.
+    static bool ImportGeometry(string const &path, ModelData &data)
     {
-        // read file via ASSIMP
-        Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-        // check for errors
-        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        data.path = path;
+        // retrieve the directory path of the filepath
+        data.directory = path.substr(0, path.find_last_of('/'));
+
+        ImportProfile profile = ImportProfile::ForModel(path);
+        uint64_t sourceHash = HashModelSource(path);
+        shared_ptr<MeshCache> cache = make_shared<MeshCache>();
+        bool cached;
         {
-            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            LoadProfiler::Scope timer(path, LoadProfiler::Cache);
+            cached = cache->Open(path, sourceHash, profile.Key());
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
+        if (cached)
+        {
+            data.meshes = std::move(cache->meshes);
+            data.nodes = std::move(cache->nodes);
+            data.cache = cache;
+        }
+        else
+        {
+            // glTF and OBJ are read by the native loaders; other formats, and files those can't read, go through ASSIMP
+            bool native;
+            {
+                LoadProfiler::Scope timer(path, LoadProfiler::Parse);
+                native = importNative(path, profile, data.meshes, data.nodes);
+            }
+            if (!native)
+            {
+                data.meshes.clear();
+                data.nodes = NodeHierarchy();
+                // read file via ASSIMP
+                Assimp::Importer importer;
+                importer.SetIOHandler(new VfsIOSystem());
+                const aiScene* scene;
+                {
+                    LoadProfiler::Scope timer(path, LoadProfiler::Parse);
+                    scene = importer.ReadFile(path, profile.PostProcessFlags());
+                }
+                // check for errors
+                if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+                {
+                    cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
+                    return false;
+                }
 
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
-    }
+                // process ASSIMP's root node recursively
+                LoadProfiler::Scope timer(path, LoadProfiler::Convert);
+                processNode(scene->mRootNode, scene, profile, data.meshes, data.nodes);
+            }
+            {
+                LoadProfiler::Scope timer(path, LoadProfiler::Optimize);
+                optimizeMeshes(path, profile, data.meshes);
+            }
+            if (profile.recenter)
+                recenter(data.meshes, data.nodes);
+            LoadProfiler::Scope timer(path, LoadProfiler::Cache);
+            MeshCache::Write(path, sourceHash, profile.Key(), data.meshes, data.nodes);
+        }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
-    {
-        // process each mesh located at the current node
-        for(unsigned int i = 0; i < node->mNumMeshes; i++)
+        for (unsigned int i = 0; i < data.meshes.size(); i++)
         {
-            // the node object only contains indices to index the actual objects in the scene.
-            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            data.boundsMin = i == 0 ? data.meshes[i].boundsMin : glm::min(data.boundsMin, data.meshes[i].boundsMin);
+            data.boundsMax = i == 0 ? data.meshes[i].boundsMax : glm::max(data.boundsMax, data.meshes[i].boundsMax);
         }
-        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
-        for(unsigned int i = 0; i < node->mNumChildren; i++)
+        return true;
+    }
+
+    // the block format a texture slot is cooked to
+    static TextureCompression::Usage TextureUsage(const TextureRef &ref)
+    {
+        return ref.type == "texture_normal" ? TextureCompression::Normal : TextureCompression::Color;
+    }
+
+    // GL half of loading: creates the buffers and textures for imported data. Must run on the thread owning the GL context.
+    void Upload(ModelData &data)
+    {
+        directory = data.directory;
+        boundsMin = data.boundsMin;
+        boundsMax = data.boundsMax;
+        nodes = std::move(data.nodes);
+        nodes.UpdateWorld();
+        meshes.reserve(data.meshes.size());
+        for (MeshData &mesh : data.meshes)
         {
-            processNode(node->mChildren[i], scene);
+            vector<Texture> textures;
+            for (const TextureRef &ref : mesh.textures)
+                textures.push_back(loadTexture(ref, data.images));
+            LoadProfiler::Scope timer(data.path, LoadProfiler::Upload, mesh.packed.vertices.size() + mesh.packed.indices.size(), true);
+            meshes.emplace_back(std::move(mesh), std::move(textures), data.keepGeometry);
+            meshes.back().SetTexturePrefix(shaderTextureNamePrefix);
         }
+        data.meshes.clear();
+        data.images.clear();
+        data.cache.reset();
+    }
 
+private:
+    // imports the formats that have a native loader; false leaves the file to ASSIMP
+    static bool importNative(string const &path, const ImportProfile &profile, vector<MeshData> &meshes, NodeHierarchy &nodes)
+    {
+        if (GltfLoader::Handles(path))
+            return GltfLoader().Load(path, profile, meshes, nodes);
+        if (ObjLoader::Handles(path))
+            return ObjLoader().Load(path, profile, meshes);
+        return false;
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    // welds and reorders freshly imported geometry for the vertex cache, overdraw and vertex fetch before it is cached
+    static void optimizeMeshes(string const &path, const ImportProfile &profile, vector<MeshData> &meshes)
     {
-        // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        if (!profile.weld && !profile.optimize)
+            return;
+        MeshOptimizer::CacheStats before, after;
+        for (MeshData &mesh : meshes)
+            MeshOptimizer::Optimize(mesh, profile.weld, profile.optimize, before, after);
+        cout << "MESH_OPTIMIZER:: " << path << ": ACMR " << before.ACMR() << " -> " << after.ACMR()
+             << ", ATVR " << before.ATVR() << " -> " << after.ATVR() << endl;
+    }
 
-        // walk through each of the mesh's vertices
-        for(unsigned int i = 0; i < mesh->mNumVertices; i++)
+    // moves the model origin to the bottom center of its bounds, so a scene places the model by where it stands instead of
+    // wherever its exporter left it. Baked meshes are shifted in place, meshes below kept nodes through the root nodes.
+    static void recenter(vector<MeshData> &meshes, NodeHierarchy &nodes)
+    {
+        // bounds of meshes below a kept node are relative to it; take them to the model in the rest pose
+        nodes.UpdateWorld();
+        glm::vec3 modelMin(0.0f), modelMax(0.0f);
+        bool empty = true;
+        for (const MeshData &mesh : meshes)
         {
-            Vertex vertex;
-            glm::vec3 vector; // we declare a placeholder vector since assimp_ uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
-            // positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
-            // normals
-            if (mesh->HasNormals())
+            if (mesh.VertexCount() == 0)
+                continue;
+            glm::mat4 frame = mesh.node == NodeHierarchy::NoNode ? glm::mat4(1.0f) : nodes.World(mesh.node);
+            for (int corner = 0; corner < 8; corner++)
             {
-                vector.x = mesh->mNormals[i].x;
-                vector.y = mesh->mNormals[i].y;
-                vector.z = mesh->mNormals[i].z;
-                vertex.Normal = vector;
+                glm::vec3 point(corner & 1 ? mesh.boundsMax.x : mesh.boundsMin.x, corner & 2 ? mesh.boundsMax.y : mesh.boundsMin.y,
+                                corner & 4 ? mesh.boundsMax.z : mesh.boundsMin.z);
+                point = glm::vec3(frame * glm::vec4(point, 1.0f));
+                modelMin = empty ? point : glm::min(modelMin, point);
+                modelMax = empty ? point : glm::max(modelMax, point);
+                empty = false;
             }
-            // texture coordinates
-            if(mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+        }
+        if (empty)
+            return;
+
+        glm::vec3 anchor((modelMin.x + modelMax.x) * 0.5f, modelMin.y, (modelMin.z + modelMax.z) * 0.5f);
+        for (MeshData &mesh : meshes)
+        {
+            if (mesh.node != NodeHierarchy::NoNode)
+                continue;
+            for (Vertex &vertex : mesh.vertices)
+                vertex.Position -= anchor;
+            mesh.boundsMin -= anchor;
+            mesh.boundsMax -= anchor;
+        }
+        glm::mat4 shift = glm::translate(glm::mat4(1.0f), -anchor);
+        for (int node = 0; node < nodes.Count(); node++)
+            if (nodes.Parent(node) == NodeHierarchy::NoNode)
+                nodes.SetLocal(node, shift * nodes.Local(node));
+    }
+
+    // a mesh found in the node tree, with the transform from its node to the nearest kept node (or the model)
+    struct MeshSource {
+        const aiMesh *mesh;
+        glm::mat4 frame;
+        int node;
+    };
+
+    // processes a node in a recursive fashion. Collects each individual mesh located at the node and repeats this process on
+    // its children nodes (if any), keeping the nodes an animation targets in nodes; the meshes are converted and their node
+    // transforms baked in afterwards, in parallel. See NodeHierarchy.
+    static void processNode(aiNode *node, const aiScene *scene, const ImportProfile &profile, vector<MeshData> &meshes,
+                            NodeHierarchy &nodes)
+    {
+        vector<string> animated;
+        for (unsigned int i = 0; i < scene->mNumAnimations && !profile.pretransform; i++)
+            for (unsigned int c = 0; c < scene->mAnimations[i]->mNumChannels; c++)
+                animated.push_back(scene->mAnimations[i]->mChannels[c]->mNodeName.C_Str());
+        vector<MeshSource> sources;
+        collectMeshes(node, scene, animated, glm::mat4(1.0f), NodeHierarchy::NoNode, sources, nodes);
+        size_t first = meshes.size();
+        meshes.resize(first + sources.size());
+        ThreadPool::Instance().ParallelFor(sources.size(), [&](size_t i) {
+            MeshData &mesh = meshes[first + i];
+            mesh = processMesh(sources[i].mesh, scene);
+            mesh.node = sources[i].node;
+            if (sources[i].frame != glm::mat4(1.0f))
             {
-                glm::vec2 vec;
-                // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
-                // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
-                // tangent
-                vector.x = mesh->mTangents[i].x;
-                vector.y = mesh->mTangents[i].y;
-                vector.z = mesh->mTangents[i].z;
-                vertex.Tangent = vector;
-                // bitangent
-                vector.x = mesh->mBitangents[i].x;
-                vector.y = mesh->mBitangents[i].y;
-                vector.z = mesh->mBitangents[i].z;
-                vertex.Bitangent = vector;
+                MeshAttributes::Transform(mesh.vertices, mesh.indices, sources[i].frame);
+                mesh.ComputeBounds();
             }
-            else
-                vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-
-            vertices.push_back(vertex);
+        });
+    }
 
+    static void collectMeshes(aiNode *node, const aiScene *scene, const vector<string> &animated, const glm::mat4 &parent,
+                              int kept, vector<MeshSource> &sources, NodeHierarchy &nodes)
+    {
+        // aiMatrix4x4 is row major
+        const aiMatrix4x4 &m = node->mTransformation;
+        glm::mat4 frame = parent * glm::mat4(glm::vec4(m.a1, m.b1, m.c1, m.d1), glm::vec4(m.a2, m.b2, m.c2, m.d2),
+                                             glm::vec4(m.a3, m.b3, m.c3, m.d3), glm::vec4(m.a4, m.b4, m.c4, m.d4));
+        if (std::find(animated.begin(), animated.end(), node->mName.C_Str()) != animated.end())
+        {
+            kept = nodes.Add(node->mName.C_Str(), kept, frame);
+            frame = glm::mat4(1.0f);
+        }
+        // the node object only contains indices to index the actual objects in the scene.
+        // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+        for(unsigned int i = 0; i < node->mNumMeshes; i++)
+            sources.push_back(MeshSource{scene->mMeshes[node->mMeshes[i]], frame, kept});
+        for(unsigned int i = 0; i < node->mNumChildren; i++)
+            collectMeshes(node->mChildren[i], scene, animated, frame, kept, sources, nodes);
+    }
 
+    static MeshData processMesh(const aiMesh *mesh, const aiScene *scene)
+    {
+        // data to fill
+        MeshData data;
+        vector<Vertex> &vertices = data.vertices;
+        vector<unsigned int> &indices = data.indices;
+        vector<TextureRef> &textures = data.textures;
+
+        // convert the attribute arrays into the interleaved vertices; absent attributes stay zero
+        vertices.resize(mesh->mNumVertices);
+        if (mesh->HasTangentsAndBitangents())   // only present when the import profile asks for a tangent frame
+        {
+            copyVec3(mesh->mTangents, vertices, offsetof(Vertex, Tangent));
+            copyVec3(mesh->mBitangents, vertices, offsetof(Vertex, Bitangent));
         }
+        copyVec3(mesh->mVertices, vertices, offsetof(Vertex, Position));
+        if (mesh->HasNormals())
+            copyVec3(mesh->mNormals, vertices, offsetof(Vertex, Normal));
+        // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
+        // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
+        if (mesh->mTextureCoords[0])
+            copyTexCoords(mesh->mTextureCoords[0], vertices);
+
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+        size_t indexCount = 0;
+        for(unsigned int i = 0; i < mesh->mNumFaces; i++)
+            indexCount += mesh->mFaces[i].mNumIndices;
+        indices.resize(indexCount);
+        unsigned int *index = indices.data();
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace &face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in the indices vector
-            for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
+            index = std::copy(face.mIndices, face.mIndices + face.mNumIndices, index);
         }
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
@@ -164,96 +456,109 @@ private:
 
 
         // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+        vector<TextureRef> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
         textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
         // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+        vector<TextureRef> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
         textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
         // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
+        std::vector<TextureRef> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
         textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
         // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
+        std::vector<TextureRef> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
 
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // return the extracted mesh data; the GL objects are created later by Upload
+        data.ComputeBounds();
+        return data;
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "the conversion kernels expect single precision ASSIMP");
+
+    // copies one aiVector3D per vertex into the vec3 at byte offset of every vertex. With SSE each vertex takes one
+    // 4-float load and a 2-float plus a 1-float store, so nothing outside the field is written; the last vertex is
+    // copied without the load, which would read past the source array.
+    static void copyVec3(const aiVector3D *source, vector<Vertex> &vertices, size_t offset)
     {
-        vector<Texture> textures;
+        size_t count = vertices.size();
+        if (count == 0)
+            return;
+        const float *src = &source[0].x;
+        char *dst = reinterpret_cast<char *>(vertices.data()) + offset;
+        size_t i = 0;
+#ifdef __SSE2__
+        for (; i + 1 < count; i++)
+        {
+            __m128 xyz = _mm_loadu_ps(src + i * 3);
+            float *out = reinterpret_cast<float *>(dst + i * sizeof(Vertex));
+            _mm_storel_pi(reinterpret_cast<__m64 *>(out), xyz);
+            _mm_store_ss(out + 2, _mm_movehl_ps(xyz, xyz));
+        }
+#endif
+        for (; i < count; i++)
+            memcpy(dst + i * sizeof(Vertex), src + i * 3, 3 * sizeof(float));
+    }
+
+    // copies the xy of the first texture coordinate set, one 2-float store per vertex
+    static void copyTexCoords(const aiVector3D *source, vector<Vertex> &vertices)
+    {
+        const float *src = &source[0].x;
+        Vertex *dst = vertices.data();
+        size_t i = 0;
+#ifdef __SSE2__
+        for (; i + 1 < vertices.size(); i++)
+            _mm_storel_pi(reinterpret_cast<__m64 *>(&dst[i].TexCoords), _mm_loadu_ps(src + i * 3));
+#endif
+        for (; i < vertices.size(); i++)
+            dst[i].TexCoords = glm::vec2(src[i * 3], src[i * 3 + 1]);
+    }
+
+    // collects all material textures of a given type; they are decoded by Import and uploaded by Upload.
+    static vector<TextureRef> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    {
+        vector<TextureRef> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            textures.push_back(TextureRef{typeName, str.C_Str()});
         }
         return textures;
     }
-};
-
-
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
-{
-    string filename = string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
+    // uploads a single decoded texture of the given type, reusing it if this model already loaded the same file.
+    Texture loadTexture(const TextureRef &ref, const map<string, ImageData> &images)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        // check if texture was loaded before and if so, skip loading a new texture
+        auto loaded = texturesByPath.find(ref.path);
+        if (loaded != texturesByPath.end())
+        {
+            Texture texture = textures_loaded[loaded->second]; // a texture with the same filepath has already been loaded (optimization)
+            texture.type = ref.type;
+            return texture;
+        }
+        // if this model hasn't used the texture yet, take it from the process-wide registry, which uploads it only if no other
+        // model has the same file or the same pixels resident
+        ImageData image;
+        auto decoded = images.find(ref.path);
+        if (decoded != images.end())
+            image = decoded->second;
+        else
+            image.canonicalPath = CanonicalPath(directory + '/' + ref.path);
+        Texture texture;
+        texture.id = TextureRegistry::Instance().Acquire(image);
+        texture.type = ref.type;
+        texture.path = ref.path;
+        texturesByPath[ref.path] = textures_loaded.size();
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+        return texture;
     }
 
-    return textureID;
-}
+    unordered_map<string, size_t> texturesByPath;   // index into textures_loaded
+    string shaderTextureNamePrefix;
+};
+
+
 #endif
@@ -0,0 +1,88 @@
+#ifndef NODE_HIERARCHY_H
+#define NODE_HIERARCHY_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// The nodes of an imported model that move relative to it. Importers bake the transform of every static node into the
+// vertices of the meshes below it, so a model without animation keeps no nodes at all; only nodes an animation targets are
+// kept here. Their local transforms fold in the static nodes between them and their nearest kept ancestor, and meshes below
+// a kept node are baked relative to it and drawn with its world matrix (see Model::Draw).
+//
+// Nodes live in parallel arrays in an order where every parent precedes its children, so world matrices are brought up to
+// date by one forward pass that reads each parent's result before its children need it. The pass starts at the first node
+// changed since the last one and is skipped entirely when nothing moved.
+//
+//     int wing = model.nodes.Find("MidWing1.R_8");
+//     model.nodes.SetLocal(wing, pose);
+//     model.nodes.UpdateWorld();      // once per frame, before drawing
+class NodeHierarchy
+{
+public:
+    enum { NoNode = -1 };
+
+    // appends a node under parent, which must already exist; local is relative to the parent, or to the model for roots
+    int Add(const std::string &name, int parent, const glm::mat4 &local)
+    {
+        int index = (int) parents.size();
+        parents.push_back(parent >= 0 && parent < index ? parent : (int) NoNode);
+        locals.push_back(local);
+        worlds.push_back(glm::mat4(1.0f));
+        normals.push_back(glm::mat3(1.0f));
+        names.push_back(name);
+        firstDirty = std::min(firstDirty, (size_t) index);
+        return index;
+    }
+
+    // first node called name, or NoNode
+    int Find(const std::string &name) const
+    {
+        for (size_t i = 0; i < names.size(); i++)
+            if (names[i] == name)
+                return (int) i;
+        return NoNode;
+    }
+
+    int Count() const { return (int) parents.size(); }
+    bool Empty() const { return parents.empty(); }
+    const std::string &Name(int node) const { return names[node]; }
+    int Parent(int node) const { return parents[node]; }
+    const glm::mat4 &Local(int node) const { return locals[node]; }
+
+    void SetLocal(int node, const glm::mat4 &local)
+    {
+        locals[node] = local;
+        firstDirty = std::min(firstDirty, (size_t) node);
+    }
+
+    // relative to the model, as of the last UpdateWorld(); Normal() is the matching transpose(inverse(mat3(World())))
+    const glm::mat4 &World(int node) const { return worlds[node]; }
+    const glm::mat3 &Normal(int node) const { return normals[node]; }
+
+    void UpdateWorld()
+    {
+        size_t count = parents.size();
+        for (size_t i = firstDirty; i < count; i++)
+        {
+            int parent = parents[i];
+            worlds[i] = parent == NoNode ? locals[i] : worlds[parent] * locals[i];
+            normals[i] = glm::transpose(glm::inverse(glm::mat3(worlds[i])));
+        }
+        firstDirty = count;
+    }
+
+private:
+    // hot: read or written by UpdateWorld
+    std::vector<int> parents;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<glm::mat3> normals;
+    size_t firstDirty = 0;          // no node before it changed since the last UpdateWorld
+
+    // cold
+    std::vector<std::string> names;
+};
+#endif
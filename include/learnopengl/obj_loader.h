@@ -0,0 +1,513 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/import_profile.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/mesh_attributes.h>
+#include <learnopengl/thread_pool.h>
+#include <learnopengl/virtual_file_system.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Native Wavefront OBJ/MTL importer used by Model::Import instead of ASSIMP for .obj files.
+//
+// The mapped file is cut into chunks at line boundaries and parsed in three passes:
+//
+//   1. every chunk parses its v/vt/vn records and triangulated faces as one task on the thread pool, with indices kept
+//      relative to the chunk when they can't be resolved yet (negative OBJ indices, counts of the chunks before it)
+//   2. once the prefix counts and the material of each chunk's first face are known, every chunk resolves its corners
+//      and welds them into one vertex pool per material, again in parallel
+//   3. the pools of each material are merged in file order, welding corners shared across chunk boundaries
+//
+// The result is one MeshData per material in order of first use, with the texture slots Model::processMesh reads from
+// ASSIMP's OBJ materials (map_Kd, map_Ks, map_Bump, map_Ka). Faces outside any usemtl get no textures. From the
+// ImportProfile it honours normals, tangents and flipUVs; objects and groups are not kept apart, since the renderer
+// only draws per material. Files it can't parse return false and the caller falls back to ASSIMP.
+class ObjLoader
+{
+public:
+    static const size_t MinChunkSize = 64 * 1024;
+
+    // the chunks run on the given pool; ParallelFor nests, so loads started from the pool's own tasks don't add threads
+    explicit ObjLoader(ThreadPool &pool = ThreadPool::Instance()) : pool(pool) {}
+
+    static bool Handles(const std::string &path)
+    {
+        return path.size() > 4 && path.compare(path.size() - 4, 4, ".obj") == 0;
+    }
+
+    // cuts the file into one chunk per pool thread, bounded by the number of MinChunkSize chunks
+    bool Load(const std::string &path, const ImportProfile &profile, std::vector<MeshData> &meshes)
+    {
+        FileView file = VirtualFileSystem::Instance().Open(path);
+        if (!file)
+        {
+            std::cout << "ERROR::OBJ:: could not open " << path << std::endl;
+            return false;
+        }
+        const char *begin = reinterpret_cast<const char *>(file.data);
+        const char *end = begin + file.size;
+
+        size_t chunkCount = std::max<size_t>(1, std::min<size_t>(pool.ThreadCount(), file.size / MinChunkSize));
+        std::vector<Chunk> chunks(chunkCount);
+        const char *chunkBegin = begin;
+        for (size_t i = 0; i < chunkCount; i++)
+        {
+            const char *chunkEnd = i + 1 == chunkCount ? end : begin + file.size * (i + 1) / chunkCount;
+            chunkEnd = std::max(chunkEnd, chunkBegin);
+            while (chunkEnd < end && chunkEnd[-1] != '\n')
+                chunkEnd++;
+            chunks[i].begin = chunkBegin;
+            chunks[i].end = chunkEnd;
+            chunkBegin = chunkEnd;
+        }
+
+        pool.ParallelFor(chunks.size(), [&chunks](size_t i) { parseChunk(chunks[i]); });
+        for (const Chunk &chunk : chunks)
+            if (!chunk.valid)
+            {
+                std::cout << "ERROR::OBJ:: malformed record in " << path << std::endl;
+                return false;
+            }
+
+        // concatenate the attribute streams and hand every chunk its offsets and starting material
+        std::vector<glm::vec3> positions, normals;
+        std::vector<glm::vec2> texCoords;
+        std::vector<std::string> materialNames(1);   // 0: faces before any usemtl
+        std::unordered_map<std::string, int> materialIds;
+        std::string library;
+        int material = 0;
+        for (Chunk &chunk : chunks)
+        {
+            chunk.positionBase = (int) positions.size();
+            chunk.texCoordBase = (int) texCoords.size();
+            chunk.normalBase = (int) normals.size();
+            chunk.firstMaterial = material;
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+            normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+            for (MaterialSwitch &use : chunk.materials)
+            {
+                auto id = materialIds.emplace(use.name, (int) materialNames.size());
+                if (id.second)
+                    materialNames.push_back(use.name);
+                use.id = material = id.first->second;
+            }
+            if (library.empty())
+                library = chunk.library;
+        }
+
+        bool flipUVs = profile.flipUVs;
+        pool.ParallelFor(chunks.size(), [&](size_t i) { weldChunk(chunks[i], positions, texCoords, normals, materialNames.size(), flipUVs); });
+        for (const Chunk &chunk : chunks)
+            if (!chunk.valid)
+            {
+                std::cout << "ERROR::OBJ:: face index out of range in " << path << std::endl;
+                return false;
+            }
+
+        std::string directory = path.substr(0, path.find_last_of('/'));
+        std::unordered_map<std::string, std::vector<TextureRef>> materialTextures;
+        if (!library.empty())
+            loadMaterialLibrary(directory + '/' + library, materialTextures);
+
+        bool hasNormals = !normals.empty();
+        for (size_t id = 0; id < materialNames.size(); id++)
+        {
+            MeshData mesh;
+            mergePools(chunks, id, mesh);
+            if (mesh.indices.empty())
+                continue;
+            if (!hasNormals && profile.normals == ImportProfile::FlatNormals)
+                MeshAttributes::GenerateFlatNormals(mesh.vertices, mesh.indices);
+            else if (!hasNormals && profile.normals == ImportProfile::SmoothNormals)
+                MeshAttributes::GenerateSmoothNormals(mesh.vertices, mesh.indices);
+            if (profile.tangents && !texCoords.empty())
+                MeshAttributes::GenerateTangents(mesh.vertices, mesh.indices);
+            auto textures = materialTextures.find(materialNames[id]);
+            if (id != 0 && textures != materialTextures.end())
+                mesh.textures = textures->second;
+            mesh.ComputeBounds();
+            meshes.push_back(std::move(mesh));
+        }
+        return true;
+    }
+
+    // locale-independent decimal parser for the fixed and exponent notation exporters write; advances cursor
+    static float ParseFloat(const char *&cursor, const char *end)
+    {
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        bool negative = false;
+        if (cursor < end && (*cursor == '-' || *cursor == '+'))
+            negative = *cursor++ == '-';
+        uint64_t digits = 0;
+        int exponent = 0;
+        for (; cursor < end && isDigit(*cursor); cursor++)
+        {
+            if (digits < 100000000000000000ull)
+                digits = digits * 10 + (*cursor - '0');
+            else
+                exponent++;
+        }
+        if (cursor < end && *cursor == '.')
+            for (cursor++; cursor < end && isDigit(*cursor); cursor++)
+                if (digits < 100000000000000000ull)
+                {
+                    digits = digits * 10 + (*cursor - '0');
+                    exponent--;
+                }
+        if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+        {
+            cursor++;
+            exponent += parseInt(cursor, end);
+        }
+        // exact for up to 15 significant digits and |exponent| <= 22, which covers everything exporters write
+        double value = (double) digits;
+        if (exponent < 0)
+            value = -exponent <= 22 ? value / powers[-exponent] : value * std::pow(10.0, exponent);
+        else if (exponent > 0)
+            value = exponent <= 22 ? value * powers[exponent] : value * std::pow(10.0, exponent);
+        return (float) (negative ? -value : value);
+    }
+
+private:
+    ThreadPool &pool;
+
+    // one face corner; components flagged in relative are offsets from the chunk's base count, the others are
+    // absolute 0-based indices or Missing
+    struct Corner {
+        int position, texCoord, normal;
+        unsigned char relative;
+    };
+    static const int Missing = INT_MIN;
+    enum { RelativePosition = 1, RelativeTexCoord = 2, RelativeNormal = 4 };
+
+    struct MaterialSwitch {
+        size_t corner;      // first corner drawn with the material
+        std::string name;
+        int id = 0;
+    };
+
+    // resolved corner, the welding key
+    struct Key {
+        int position, texCoord, normal;
+        bool operator==(const Key &other) const
+        {
+            return position == other.position && texCoord == other.texCoord && normal == other.normal;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const
+        {
+            return ((size_t) key.position * 73856093u) ^ ((size_t) key.texCoord * 19349663u) ^ ((size_t) key.normal * 83492791u);
+        }
+    };
+
+    struct Pool {
+        std::vector<Vertex> vertices;
+        std::vector<Key> keys;
+        std::vector<unsigned int> indices;
+    };
+
+    struct Chunk {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        bool valid = true;
+        std::vector<glm::vec3> positions, normals;
+        std::vector<glm::vec2> texCoords;
+        std::vector<Corner> corners;
+        std::vector<MaterialSwitch> materials;
+        std::string library;
+        int positionBase = 0, texCoordBase = 0, normalBase = 0;
+        int firstMaterial = 0;
+        std::vector<Pool> pools;    // per material id
+    };
+
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    static void skipSpace(const char *&cursor, const char *end)
+    {
+        while (cursor < end && isSpace(*cursor))
+            cursor++;
+    }
+
+    static int parseInt(const char *&cursor, const char *end)
+    {
+        bool negative = false;
+        if (cursor < end && (*cursor == '-' || *cursor == '+'))
+            negative = *cursor++ == '-';
+        int value = 0;
+        for (; cursor < end && isDigit(*cursor); cursor++)
+            value = value * 10 + (*cursor - '0');
+        return negative ? -value : value;
+    }
+
+    static bool keyword(const char *cursor, const char *end, const char *word)
+    {
+        size_t length = strlen(word);
+        return (size_t) (end - cursor) > length && strncmp(cursor, word, length) == 0 && isSpace(cursor[length]);
+    }
+
+    // rest of the line with surrounding whitespace trimmed
+    static std::string restOfLine(const char *cursor, const char *lineEnd)
+    {
+        skipSpace(cursor, lineEnd);
+        while (lineEnd > cursor && isSpace(lineEnd[-1]))
+            lineEnd--;
+        return std::string(cursor, lineEnd);
+    }
+
+    // reads one index of a face corner: 1-based absolute or negative relative to the records parsed so far
+    static bool parseIndex(const char *&cursor, const char *end, size_t localCount, int &index, bool &relative)
+    {
+        if (cursor >= end || !(isDigit(*cursor) || *cursor == '-'))
+            return false;
+        int value = parseInt(cursor, end);
+        if (value == 0)
+            return false;
+        // negative indices count back from the records parsed so far, so they become offsets from the chunk's base
+        index = value > 0 ? value - 1 : (int) localCount + value;
+        relative = value < 0;
+        return true;
+    }
+
+    static void parseChunk(Chunk &chunk)
+    {
+        std::vector<Corner> face;
+        const char *cursor = chunk.begin;
+        while (cursor < chunk.end)
+        {
+            const char *lineEnd = (const char *) memchr(cursor, '\n', chunk.end - cursor);
+            if (!lineEnd)
+                lineEnd = chunk.end;
+            skipSpace(cursor, lineEnd);
+
+            if (keyword(cursor, lineEnd, "v"))
+            {
+                cursor += 1;
+                glm::vec3 position;
+                for (int c = 0; c < 3; c++)
+                {
+                    skipSpace(cursor, lineEnd);
+                    position[c] = ParseFloat(cursor, lineEnd);
+                }
+                chunk.positions.push_back(position);
+            }
+            else if (keyword(cursor, lineEnd, "vt"))
+            {
+                cursor += 2;
+                glm::vec2 texCoord;
+                for (int c = 0; c < 2; c++)
+                {
+                    skipSpace(cursor, lineEnd);
+                    texCoord[c] = ParseFloat(cursor, lineEnd);
+                }
+                chunk.texCoords.push_back(texCoord);
+            }
+            else if (keyword(cursor, lineEnd, "vn"))
+            {
+                cursor += 2;
+                glm::vec3 normal;
+                for (int c = 0; c < 3; c++)
+                {
+                    skipSpace(cursor, lineEnd);
+                    normal[c] = ParseFloat(cursor, lineEnd);
+                }
+                chunk.normals.push_back(normal);
+            }
+            else if (keyword(cursor, lineEnd, "f"))
+            {
+                cursor += 1;
+                face.clear();
+                for (skipSpace(cursor, lineEnd); cursor < lineEnd; skipSpace(cursor, lineEnd))
+                {
+                    Corner corner = {Missing, Missing, Missing, 0};
+                    bool relative;
+                    if (!parseIndex(cursor, lineEnd, chunk.positions.size(), corner.position, relative))
+                    {
+                        chunk.valid = false;
+                        return;
+                    }
+                    corner.relative |= relative ? RelativePosition : 0;
+                    if (cursor < lineEnd && *cursor == '/')
+                    {
+                        cursor++;
+                        if (cursor < lineEnd && *cursor != '/')
+                        {
+                            if (!parseIndex(cursor, lineEnd, chunk.texCoords.size(), corner.texCoord, relative))
+                            {
+                                chunk.valid = false;
+                                return;
+                            }
+                            corner.relative |= relative ? RelativeTexCoord : 0;
+                        }
+                        if (cursor < lineEnd && *cursor == '/')
+                        {
+                            cursor++;
+                            if (!parseIndex(cursor, lineEnd, chunk.normals.size(), corner.normal, relative))
+                            {
+                                chunk.valid = false;
+                                return;
+                            }
+                            corner.relative |= relative ? RelativeNormal : 0;
+                        }
+                    }
+                    face.push_back(corner);
+                }
+                // fan triangulation, as aiProcess_Triangulate does for the convex polygons exporters write
+                for (size_t i = 2; i < face.size(); i++)
+                {
+                    chunk.corners.push_back(face[0]);
+                    chunk.corners.push_back(face[i - 1]);
+                    chunk.corners.push_back(face[i]);
+                }
+            }
+            else if (keyword(cursor, lineEnd, "usemtl"))
+                chunk.materials.push_back(MaterialSwitch{chunk.corners.size(), restOfLine(cursor + 6, lineEnd)});
+            else if (keyword(cursor, lineEnd, "mtllib") && chunk.library.empty())
+                chunk.library = restOfLine(cursor + 6, lineEnd);
+
+            cursor = lineEnd + 1;
+        }
+    }
+
+    static void weldChunk(Chunk &chunk, const std::vector<glm::vec3> &positions, const std::vector<glm::vec2> &texCoords,
+                          const std::vector<glm::vec3> &normals, size_t materialCount, bool flipUVs)
+    {
+        chunk.pools.resize(materialCount);
+        std::vector<std::unordered_map<Key, unsigned int, KeyHash>> welded(materialCount);
+        int material = chunk.firstMaterial;
+        size_t nextSwitch = 0;
+        for (size_t i = 0; i < chunk.corners.size(); i++)
+        {
+            while (nextSwitch < chunk.materials.size() && chunk.materials[nextSwitch].corner == i)
+                material = chunk.materials[nextSwitch++].id;
+
+            const Corner &corner = chunk.corners[i];
+            Key key = {corner.position + (corner.relative & RelativePosition ? chunk.positionBase : 0),
+                       corner.texCoord + (corner.relative & RelativeTexCoord ? chunk.texCoordBase : 0),
+                       corner.normal + (corner.relative & RelativeNormal ? chunk.normalBase : 0)};
+            if (key.position < 0 || key.position >= (int) positions.size()
+                || (key.texCoord != Missing && (key.texCoord < 0 || key.texCoord >= (int) texCoords.size()))
+                || (key.normal != Missing && (key.normal < 0 || key.normal >= (int) normals.size())))
+            {
+                chunk.valid = false;
+                return;
+            }
+
+            Pool &pool = chunk.pools[material];
+            auto found = welded[material].emplace(key, (unsigned int) pool.vertices.size());
+            if (found.second)
+            {
+                Vertex vertex = {};
+                vertex.Position = positions[key.position];
+                if (key.texCoord != Missing)
+                    vertex.TexCoords = flipUVs ? glm::vec2(texCoords[key.texCoord].x, 1.0f - texCoords[key.texCoord].y)
+                                               : texCoords[key.texCoord];
+                if (key.normal != Missing)
+                    vertex.Normal = normals[key.normal];
+                pool.vertices.push_back(vertex);
+                pool.keys.push_back(key);
+            }
+            pool.indices.push_back(found.first->second);
+        }
+        std::vector<Corner>().swap(chunk.corners);
+    }
+
+    static void mergePools(std::vector<Chunk> &chunks, size_t material, MeshData &mesh)
+    {
+        size_t vertexCount = 0, indexCount = 0;
+        for (const Chunk &chunk : chunks)
+        {
+            vertexCount += chunk.pools[material].vertices.size();
+            indexCount += chunk.pools[material].indices.size();
+        }
+        mesh.vertices.reserve(vertexCount);
+        mesh.indices.reserve(indexCount);
+
+        std::unordered_map<Key, unsigned int, KeyHash> welded(vertexCount);
+        std::vector<unsigned int> remap;
+        for (Chunk &chunk : chunks)
+        {
+            Pool &pool = chunk.pools[material];
+            remap.resize(pool.vertices.size());
+            for (size_t i = 0; i < pool.vertices.size(); i++)
+            {
+                auto found = welded.emplace(pool.keys[i], (unsigned int) mesh.vertices.size());
+                if (found.second)
+                    mesh.vertices.push_back(pool.vertices[i]);
+                remap[i] = found.first->second;
+            }
+            for (unsigned int index : pool.indices)
+                mesh.indices.push_back(remap[index]);
+            pool = Pool();
+        }
+    }
+
+    // texture maps of every material in an MTL file, in the slots Model::processMesh assigns ASSIMP's texture types
+    static void loadMaterialLibrary(const std::string &path, std::unordered_map<std::string, std::vector<TextureRef>> &materials)
+    {
+        FileView library = VirtualFileSystem::Instance().Open(path);
+        if (!library)
+        {
+            std::cout << "ERROR::OBJ:: could not open material library " << path << std::endl;
+            return;
+        }
+        std::istringstream file(library.String());
+        std::vector<TextureRef> *current = nullptr;
+        std::vector<TextureRef> diffuse, specular, normal, height;
+        auto flush = [&]() {
+            if (!current)
+                return;
+            // same order as processMesh: diffuse, specular, normal, height
+            for (std::vector<TextureRef> *maps : {&diffuse, &specular, &normal, &height})
+            {
+                current->insert(current->end(), maps->begin(), maps->end());
+                maps->clear();
+            }
+        };
+        std::string line;
+        while (std::getline(file, line))
+        {
+            const char *begin = line.c_str();
+            const char *end = begin + line.size();
+            skipSpace(begin, end);
+            if (keyword(begin, end, "newmtl"))
+            {
+                flush();
+                current = &materials[restOfLine(begin + 6, end)];
+                continue;
+            }
+            std::string directive(begin, std::find_if(begin, end, isSpace));
+            std::vector<TextureRef> *maps = directive == "map_Kd" ? &diffuse
+                                          : directive == "map_Ks" ? &specular
+                                          : directive == "map_Bump" || directive == "map_bump" || directive == "bump" ? &normal
+                                          : directive == "map_Ka" ? &height : nullptr;
+            if (!maps)
+                continue;
+            // options such as -bm 1.0 come before the file name, which is the last token
+            std::string value = restOfLine(begin + directive.size(), end);
+            size_t space = value.find_last_of(" \t");
+            std::string texture = space == std::string::npos ? value : value.substr(space + 1);
+            std::string type = maps == &diffuse ? "texture_diffuse" : maps == &specular ? "texture_specular"
+                             : maps == &normal ? "texture_normal" : "texture_height";
+            if (!texture.empty())
+                maps->push_back(TextureRef{type, texture});
+        }
+        flush();
+    }
+};
+#endif
@@ -0,0 +1,141 @@
+#ifndef OBJECT_TRANSFORMS_H
+#define OBJECT_TRANSFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/gl_handle.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Model and normal matrices of every drawn object in one GPU buffer, read by the vertex shader through a buffer texture:
+//
+//     uniform samplerBuffer objectTransforms;     // set to ObjectTransforms::Unit
+//     uniform int objectIndex;
+//     int base = objectIndex * TEXELS_PER_OBJECT;     // defined by ShaderDefines()
+//     mat4 model = mat4(texelFetch(objectTransforms, base), ... + 1, ... + 2, ... + 3);
+//     mat3 normalMatrix = mat3(texelFetch(objectTransforms, base + 4).xyz, ... + 5, ... + 6);
+//
+// The normal matrix, transpose(inverse(model)), is computed on the CPU when an object's matrix changes instead of for
+// every vertex. SceneGraph::UpdateWorld() hands over the world matrices of the nodes that moved, and Update() sends the
+// range of objects changed since the last call.
+//
+//     ObjectTransforms transforms;
+//     unsigned int door = transforms.Add();
+//     ...
+//     transforms.Set(door, doorWorld);     // when the door moves
+//     transforms.Update();
+//     transforms.Bind();
+//     shader.setInt(ObjectIndex, door);
+//     model.Draw(shader);
+//
+// GL 3.3 has neither persistently mapped buffers nor a draw ID, so the buffer is written with glBufferSubData and the
+// object is selected through a uniform.
+class ObjectTransforms
+{
+public:
+    // texture unit the buffer is bound to; above the units meshes bind their material textures to
+    static const unsigned int Unit = 15;
+    // RGBA32F texels per object: four model matrix columns, then three normal matrix columns
+    static const unsigned int TexelsPerObject = 7;
+
+    // defines TEXELS_PER_OBJECT for shaders reading the buffer; pass to the Shader constructor
+    static std::string ShaderDefines()
+    {
+        return "#define TEXELS_PER_OBJECT " + std::to_string(TexelsPerObject) + "\n";
+    }
+
+    ObjectTransforms() : buffer(CreateBuffer())
+    {
+        unsigned int id;
+        glGenTextures(1, &id);
+        texture.reset(id);
+    }
+
+    ObjectTransforms(const ObjectTransforms &) = delete;
+    ObjectTransforms &operator=(const ObjectTransforms &) = delete;
+
+    // a new object with the identity as its model matrix
+    unsigned int Add()
+    {
+        models.push_back(glm::mat4(1.0f));
+        texels.resize(models.size() * TexelsPerObject);
+        unsigned int index = (unsigned int) models.size() - 1;
+        write(index, glm::mat4(1.0f));
+        return index;
+    }
+
+    // sets the model matrix; unchanged matrices are not sent again
+    void Set(unsigned int index, const glm::mat4 &model)
+    {
+        if (models[index] != model)
+            write(index, model);
+    }
+
+    const glm::mat4 &Model(unsigned int index) const { return models[index]; }
+
+    unsigned int Count() const { return (unsigned int) models.size(); }
+
+    // sends the objects changed since the last call, reallocating the buffer if objects were added beyond its capacity
+    void Update()
+    {
+        if (dirtyBegin >= dirtyEnd)
+            return;
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer.get());
+        if (models.size() > capacity)
+        {
+            capacity = std::max<size_t>(models.size(), capacity * 2);
+            glBufferData(GL_TEXTURE_BUFFER, capacity * TexelsPerObject * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+            dirtyBegin = 0;
+            dirtyEnd = models.size();
+            glBindTexture(GL_TEXTURE_BUFFER, texture.get());
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer.get());
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+        }
+        glBufferSubData(GL_TEXTURE_BUFFER, dirtyBegin * TexelsPerObject * sizeof(glm::vec4),
+                        (dirtyEnd - dirtyBegin) * TexelsPerObject * sizeof(glm::vec4), &texels[dirtyBegin * TexelsPerObject]);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        dirtyBegin = dirtyEnd = 0;
+    }
+
+    // binds the buffer texture to Unit, leaving texture unit 0 active
+    void Bind() const
+    {
+        glActiveTexture(GL_TEXTURE0 + Unit);
+        glBindTexture(GL_TEXTURE_BUFFER, texture.get());
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    void write(unsigned int index, const glm::mat4 &model)
+    {
+        models[index] = model;
+        glm::mat3 normal = glm::transpose(glm::inverse(glm::mat3(model)));
+        glm::vec4 *out = &texels[index * TexelsPerObject];
+        for (int column = 0; column < 4; column++)
+            out[column] = model[column];
+        for (int column = 0; column < 3; column++)
+            out[4 + column] = glm::vec4(normal[column], 0.0f);
+        if (dirtyBegin >= dirtyEnd)
+        {
+            dirtyBegin = index;
+            dirtyEnd = index + 1;
+        }
+        else
+        {
+            dirtyBegin = std::min<size_t>(dirtyBegin, index);
+            dirtyEnd = std::max<size_t>(dirtyEnd, index + 1);
+        }
+    }
+
+    BufferHandle buffer;
+    TextureHandle texture;
+    std::vector<glm::mat4> models;
+    std::vector<glm::vec4> texels;
+    size_t capacity = 0;            // objects the GPU buffer has room for
+    size_t dirtyBegin = 0;          // objects [dirtyBegin, dirtyEnd) changed since the last Update()
+    size_t dirtyEnd = 0;
+};
+#endif
@@ -0,0 +1,232 @@
+#ifndef RESIDENCY_MANAGER_H
+#define RESIDENCY_MANAGER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/asset_loader.h>
+#include <learnopengl/model.h>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Keeps only the models near the camera resident. Each tracked model is imported through the AssetLoader once the camera
+// comes within loadDistance of its bounding sphere, uploaded on the GL thread, and released (meshes and texture references)
+// once the camera is farther than evictDistance. The gap between the two distances is the hysteresis that keeps a model
+// at the edge from being loaded and evicted every other frame. Loads are prioritized by how large the model appears on
+// screen, so what fills the view arrives first.
+//
+// The estimated GPU memory of resident and loading models stays within budgetBytes: a load that would exceed it first
+// evicts resident models farther away than the one being loaded, farthest first, and waits if that is not enough.
+// Untracked models are not counted, and a texture shared with another model counts only for the one that uploaded it.
+//
+//     ResidencyManager residency(loader, layout);
+//     AssetHandle<Model> door = residency.Track("resources/objects/wooden_door/scene.gltf", doorPosition, 20.0f);
+//     ...
+//     residency.Update(camera.Position, camera.Front);   // once per frame on the GL thread, before drawing
+//     if (door)
+//         door->Draw(shader);
+//
+// The positions models are tracked at, or whatever their locate functions read, must outlive the manager.
+class ResidencyManager
+{
+public:
+    explicit ResidencyManager(AssetLoader &loader, const VertexLayout &layout = VertexLayout(), float loadDistance = 110.0f,
+                              float evictDistance = 140.0f, size_t budgetBytes = 512 * 1024 * 1024)
+            : loader(loader), layout(layout), loadDistance(loadDistance), evictDistance(std::max(loadDistance, evictDistance)),
+              budget(budgetBytes) {}
+
+    ResidencyManager(const ResidencyManager &) = delete;
+    ResidencyManager &operator=(const ResidencyManager &) = delete;
+
+    // puts a model under distance management and returns it, not yet loaded; position is read every Update, so it may be
+    // edited while running. scale is the largest scale factor the model is drawn with, which sizes its bounding sphere once
+    // the bounds are known.
+    AssetHandle<Model> Track(const std::string &path, const glm::vec3 &position, float scale = 1.0f)
+    {
+        const glm::vec3 *tracked = &position;
+        return Track(path, [tracked](const glm::vec3 &) { return *tracked; }, scale);
+    }
+
+    // as above for a model drawn in several places or one that moves: locate(camera) gives the position of the instance
+    // nearest to the camera, and is called every Update
+    AssetHandle<Model> Track(const std::string &path, std::function<glm::vec3(const glm::vec3 &camera)> locate, float scale = 1.0f)
+    {
+        Entry entry;
+        entry.handle = AssetHandle<Model>::Create();
+        entry.path = path;
+        entry.locate = std::move(locate);
+        entry.scale = scale;
+        entries.push_back(entry);
+        return entry.handle;
+    }
+
+    // GL thread, once per frame: evicts what is out of range or over budget, starts loads for what came into range and
+    // re-prioritizes the loads still waiting. Uploads happen in AssetLoader::Poll().
+    void Update(const glm::vec3 &camera, const glm::vec3 &front)
+    {
+        for (Entry &entry : entries)
+            measure(entry, camera, front);
+
+        for (Entry &entry : entries)
+        {
+            if (entry.distance <= evictDistance)
+                continue;
+            if (entry.handle.State() == AssetState::Ready)
+                evict(entry);
+            else if (entry.handle.State() == AssetState::Loading)
+                cancel(entry);
+        }
+        // hysteresis keeps models between the two distances resident only while the budget allows
+        enforceBudget(budget, loadDistance);
+
+        std::vector<Entry *> wanted;
+        for (Entry &entry : entries)
+        {
+            if (entry.handle.State() == AssetState::Loading)
+                loader.SetPriority(entry.request, entry.importance);
+            else if (entry.handle.State() == AssetState::Unloaded && entry.distance <= loadDistance)
+                wanted.push_back(&entry);
+        }
+        std::sort(wanted.begin(), wanted.end(), [](const Entry *a, const Entry *b) { return a->importance > b->importance; });
+        for (Entry *entry : wanted)
+        {
+            size_t needed = loadingBytes + entry->bytes;
+            if (!enforceBudget(needed < budget ? budget - needed : 0, entry->distance))
+                break;
+            load(*entry);
+        }
+    }
+
+    // tracked models currently loading
+    unsigned int Pending() const
+    {
+        unsigned int count = 0;
+        for (const Entry &entry : entries)
+            count += entry.handle.State() == AssetState::Loading ? 1 : 0;
+        return count;
+    }
+
+    // opt-in: models loaded afterwards free their CPU-side vertices and indices once they are uploaded
+    void KeepGeometry(bool keep) { keepGeometry = keep; }
+
+    size_t ResidentBytes() const { return residentBytes; }
+
+    void PrintStats(std::ostream &out = std::cout) const
+    {
+        unsigned int resident = 0;
+        for (const Entry &entry : entries)
+            resident += entry.handle.Ready() ? 1 : 0;
+        out << "RESIDENCY:: " << resident << "/" << entries.size() << " models resident, " << residentBytes / (1024 * 1024) << "/"
+            << budget / (1024 * 1024) << " MiB, " << loads << " loads, " << evictions << " evictions" << std::endl;
+    }
+
+private:
+    struct Entry {
+        AssetHandle<Model> handle;
+        std::string path;
+        std::function<glm::vec3(const glm::vec3 &)> locate;
+        float scale;
+        float radius = 0.0f;        // of a sphere around position containing the model in any orientation; 0 until loaded
+        float distance = 0.0f;      // from the camera to that sphere
+        float importance = 0.0f;    // load priority, see measure()
+        size_t bytes = 0;           // estimated GPU memory, known after the first load
+        AssetLoader::RequestPtr request;
+    };
+
+    // distance from the camera and screen importance: the sphere's apparent size, a quarter of it outside the view cone.
+    // Until the bounds are known a unit sphere stands in.
+    static void measure(Entry &entry, const glm::vec3 &camera, const glm::vec3 &front)
+    {
+        glm::vec3 toModel = entry.locate(camera) - camera;
+        float centerDistance = glm::length(toModel);
+        float radius = std::max(entry.radius, 1.0f);
+        entry.distance = std::max(0.0f, centerDistance - entry.radius);
+        entry.importance = radius / std::max(centerDistance, radius);
+        if (centerDistance > radius && glm::dot(toModel / centerDistance, front) < 0.5f)
+            entry.importance *= 0.25f;
+    }
+
+    void load(Entry &entry)
+    {
+        entry.handle.SetState(AssetState::Loading);
+        loadingBytes += entry.bytes;
+        loads++;
+        Entry *target = &entry;
+        std::string path = entry.path;
+        VertexLayout packLayout = layout;
+        bool keep = keepGeometry;
+        entry.request = loader.Submit([this, target, path, packLayout, keep]() {
+            shared_ptr<ModelData> data = make_shared<ModelData>(Model::Import(path, packLayout));
+            data->keepGeometry = keep;
+            return AssetLoader::GLJob([this, target, data]() { upload(*target, *data); });
+        }, entry.importance);
+    }
+
+    void upload(Entry &entry, ModelData &data)
+    {
+        loadingBytes -= std::min(loadingBytes, entry.bytes);
+        size_t bytes = 0;
+        for (const MeshData &mesh : data.meshes)
+            bytes += mesh.packed.vertices.size() + mesh.packed.indices.size();
+        for (const auto &image : data.images)
+            bytes += image.second.GpuBytes();
+        entry.handle->Upload(data);
+        entry.bytes = bytes;
+        glm::vec3 extent = glm::max(glm::abs(entry.handle->boundsMin), glm::abs(entry.handle->boundsMax));
+        entry.radius = glm::length(extent) * entry.scale;
+        entry.handle.SetState(AssetState::Ready);
+        entry.request.reset();
+        residentBytes += bytes;
+    }
+
+    void evict(Entry &entry)
+    {
+        entry.handle->Release();
+        entry.handle.SetState(AssetState::Unloaded);
+        residentBytes -= std::min(residentBytes, entry.bytes);
+        evictions++;
+    }
+
+    void cancel(Entry &entry)
+    {
+        loader.Cancel(entry.request);
+        entry.request.reset();
+        entry.handle.SetState(AssetState::Unloaded);
+        loadingBytes -= std::min(loadingBytes, entry.bytes);
+    }
+
+    // evicts resident models farther than keepDistance, farthest first, until at most limit bytes are resident; false if
+    // that is not enough
+    bool enforceBudget(size_t limit, float keepDistance)
+    {
+        while (residentBytes > limit)
+        {
+            Entry *farthest = nullptr;
+            for (Entry &entry : entries)
+                if (entry.handle.Ready() && entry.distance > keepDistance && (!farthest || entry.distance > farthest->distance))
+                    farthest = &entry;
+            if (!farthest)
+                return false;
+            evict(*farthest);
+        }
+        return true;
+    }
+
+    AssetLoader &loader;
+    VertexLayout layout;
+    float loadDistance;
+    float evictDistance;
+    size_t budget;
+    bool keepGeometry = true;
+    std::deque<Entry> entries;      // a deque, so loads in flight keep pointing at their entry while more are tracked
+    size_t loadingBytes = 0;
+    size_t residentBytes = 0;
+    size_t loads = 0;
+    size_t evictions = 0;
+};
+#endif
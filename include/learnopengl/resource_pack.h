@@ -0,0 +1,137 @@
+#ifndef RESOURCE_PACK_H
+#define RESOURCE_PACK_H
+
+#include <learnopengl/hash.h>
+#include <learnopengl/mapped_file.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Read-only archive of resource files, mapped as a whole and read in place. Layout:
+//
+//   Header
+//   file contents, each starting at a multiple of EntryAlignment, LZ4 compressed where that paid off
+//   Entry[entryCount]       sorted by path
+//   uint32_t[slotCount]     open-addressing hash table over the path hash: entry index + 1, 0 for an empty slot
+//   path strings            referenced by Entry::pathOffset, not terminated
+//
+// Paths are stored relative to the directory the pack is built from, with '/' separators. Entries whose size equals
+// their rawSize are stored uncompressed and can be handed out without a copy.
+class ResourcePack
+{
+public:
+    static const uint32_t Magic = 0x4b504b48;   // "HKPK"
+    static const uint32_t Version = 1;
+    static const size_t EntryAlignment = 16;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t slotCount;     // power of two, at least twice entryCount
+        uint64_t indexOffset;   // offset of the Entry array
+        uint64_t pathsSize;
+    };
+
+    struct Entry {
+        uint64_t pathHash;
+        uint64_t offset;
+        uint64_t size;          // stored bytes
+        uint64_t rawSize;       // bytes after decompression
+        uint32_t pathOffset;
+        uint32_t pathLength;
+    };
+
+    static uint64_t HashPath(const std::string &path) { return HashBytes(path.data(), path.size()); }
+
+    bool Open(const std::string &path)
+    {
+        Close();
+        if (!file.Open(path))
+            return false;
+        Header header;
+        if (file.size < sizeof(Header))
+            return fail(path);
+        memcpy(&header, file.data, sizeof(Header));
+        uint64_t entriesSize = (uint64_t) header.entryCount * sizeof(Entry);
+        uint64_t slotsSize = (uint64_t) header.slotCount * sizeof(uint32_t);
+        if (header.magic != Magic || header.version != Version || header.slotCount == 0
+            || (header.slotCount & (header.slotCount - 1)) != 0 || header.slotCount < 2 * (uint64_t) header.entryCount
+            || header.indexOffset % alignof(Entry) != 0
+            || header.indexOffset > file.size || entriesSize + slotsSize + header.pathsSize > file.size - header.indexOffset)
+            return fail(path);
+
+        entries = reinterpret_cast<const Entry *>(file.data + header.indexOffset);
+        slots = reinterpret_cast<const uint32_t *>(file.data + header.indexOffset + entriesSize);
+        paths = reinterpret_cast<const char *>(file.data + header.indexOffset + entriesSize + slotsSize);
+        entryCount = header.entryCount;
+        slotMask = header.slotCount - 1;
+        for (uint32_t i = 0; i < entryCount; i++)
+        {
+            const Entry &entry = entries[i];
+            if (entry.offset > header.indexOffset || entry.size > header.indexOffset - entry.offset
+                || (uint64_t) entry.pathOffset + entry.pathLength > header.pathsSize)
+                return fail(path);
+        }
+        for (uint32_t i = 0; i <= slotMask; i++)
+            if (slots[i] > entryCount)
+                return fail(path);
+        return true;
+    }
+
+    void Close()
+    {
+        file.Close();
+        entries = nullptr;
+        slots = nullptr;
+        paths = nullptr;
+        entryCount = 0;
+        slotMask = 0;
+    }
+
+    bool IsOpen() const { return file.IsOpen(); }
+    size_t EntryCount() const { return entryCount; }
+    const Entry &EntryAt(size_t index) const { return entries[index]; }
+    std::string Path(const Entry &entry) const { return std::string(paths + entry.pathOffset, entry.pathLength); }
+    const unsigned char *Data(const Entry &entry) const { return file.data + entry.offset; }
+    bool Compressed(const Entry &entry) const { return entry.size != entry.rawSize; }
+
+    // entry stored under path, or nullptr; thread-safe. The probe visits every slot at most once, so a table without an
+    // empty slot cannot make it spin.
+    const Entry *Find(const std::string &path) const
+    {
+        if (!entries)
+            return nullptr;
+        uint64_t hash = HashPath(path);
+        uint32_t slot = (uint32_t) hash & slotMask;
+        for (uint64_t probe = 0; probe <= slotMask; probe++, slot = (slot + 1) & slotMask)
+        {
+            if (slots[slot] == 0)
+                return nullptr;
+            const Entry &entry = entries[slots[slot] - 1];
+            if (entry.pathHash == hash && entry.pathLength == path.size()
+                && memcmp(paths + entry.pathOffset, path.data(), path.size()) == 0)
+                return &entry;
+        }
+        return nullptr;
+    }
+
+private:
+    bool fail(const std::string &path)
+    {
+        std::cout << "ERROR::RESOURCE_PACK:: " << path << " is not a valid version " << Version << " pack" << std::endl;
+        Close();
+        return false;
+    }
+
+    MappedFile file;
+    const Entry *entries = nullptr;
+    const uint32_t *slots = nullptr;
+    const char *paths = nullptr;
+    uint32_t entryCount = 0;
+    uint32_t slotMask = 0;
+};
+#endif
@@ -0,0 +1,167 @@
+#ifndef RESOURCE_PACK_WRITER_H
+#define RESOURCE_PACK_WRITER_H
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/lz4.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/resource_pack.h>
+#include <learnopengl/thread_pool.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Builds a ResourcePack in memory and writes it in one go. Compressed entries are only kept when LZ4 saves at least an
+// eighth of their size; already compressed formats such as PNG and JPEG are better added with compress = false.
+// Add() and AddFile() may be called from several threads.
+class ResourcePackWriter
+{
+public:
+    // formats that are already compressed and would only cost decompression time
+    static bool ShouldCompress(const std::string &path)
+    {
+        static const char *stored[] = {".png", ".jpg", ".jpeg", ".PNG", ".JPG", ".JPEG"};
+        for (const char *extension : stored)
+        {
+            size_t length = strlen(extension);
+            if (path.size() >= length && path.compare(path.size() - length, length, extension) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    bool AddFile(const std::string &path)
+    {
+        MappedFile file(path);
+        struct stat st;
+        if (!file.IsOpen() && (stat(path.c_str(), &st) != 0 || st.st_size != 0))
+        {
+            std::cout << "ERROR::RESOURCE_PACK:: could not read " << path << std::endl;
+            return false;
+        }
+        Add(path, file.data, file.size, ShouldCompress(path));
+        return true;
+    }
+
+    // adds every file below directory except those in the skipped directories, reading and compressing them on workers
+    void AddDirectory(const std::string &directory, const std::vector<std::string> &skip, ThreadPool &workers)
+    {
+        std::vector<std::string> files;
+        FileSystem::listFiles(directory, files, skip);
+        for (const std::string &path : files)
+        {
+            bool partial = path.size() >= 4 && path.compare(path.size() - 4, 4, ".tmp") == 0;   // a cache write in progress
+            if (!partial)
+                workers.Submit([this, path]() { AddFile(path); });
+        }
+        workers.Wait();
+    }
+
+    void Add(const std::string &path, const unsigned char *data, size_t size, bool compress)
+    {
+        File file;
+        file.path = path;
+        file.rawSize = size;
+        std::vector<unsigned char> compressed;
+        if (compress && LZ4::Compress(data, size, compressed) && compressed.size() <= size - size / 8)
+            file.contents.swap(compressed);
+        else
+            file.contents.assign(data, data + size);
+        std::lock_guard<std::mutex> lock(mutex);
+        rawBytes += size;
+        storedBytes += file.contents.size();
+        files.push_back(std::move(file));
+    }
+
+    size_t FileCount() const { return files.size(); }
+    size_t RawBytes() const { return rawBytes; }
+    size_t StoredBytes() const { return storedBytes; }
+
+    // writes the pack through a temporary file, so a running reader never sees a partial pack
+    bool Write(const std::string &path)
+    {
+        std::sort(files.begin(), files.end(), [](const File &a, const File &b) { return a.path < b.path; });
+
+        ResourcePack::Header header = {};
+        header.magic = ResourcePack::Magic;
+        header.version = ResourcePack::Version;
+        header.entryCount = (uint32_t) files.size();
+        header.slotCount = 1;
+        while (header.slotCount < files.size() * 2)
+            header.slotCount *= 2;
+
+        std::vector<ResourcePack::Entry> entries(files.size());
+        std::string paths;
+        uint64_t offset = align(sizeof(header));
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            entries[i].pathHash = ResourcePack::HashPath(files[i].path);
+            entries[i].offset = offset;
+            entries[i].size = files[i].contents.size();
+            entries[i].rawSize = files[i].rawSize;
+            entries[i].pathOffset = (uint32_t) paths.size();
+            entries[i].pathLength = (uint32_t) files[i].path.size();
+            paths += files[i].path;
+            offset = align(offset + entries[i].size);
+        }
+        header.indexOffset = offset;
+        header.pathsSize = paths.size();
+
+        std::vector<uint32_t> slots(header.slotCount, 0);
+        for (uint32_t i = 0; i < header.entryCount; i++)
+        {
+            uint32_t slot = (uint32_t) entries[i].pathHash & (header.slotCount - 1);
+            while (slots[slot] != 0)
+                slot = (slot + 1) & (header.slotCount - 1);
+            slots[slot] = i + 1;
+        }
+
+        std::string tempPath = path + ".tmp";
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        static const char padding[ResourcePack::EntryAlignment] = {};
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(padding, align(sizeof(header)) - sizeof(header));
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            out.write(reinterpret_cast<const char *>(files[i].contents.data()), files[i].contents.size());
+            out.write(padding, align(entries[i].offset + entries[i].size) - (entries[i].offset + entries[i].size));
+        }
+        out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(ResourcePack::Entry));
+        out.write(reinterpret_cast<const char *>(slots.data()), slots.size() * sizeof(uint32_t));
+        out.write(paths.data(), paths.size());
+        out.close();
+        if (!out || rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            std::cout << "ERROR::RESOURCE_PACK:: could not write " << path << std::endl;
+            remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct File {
+        std::string path;
+        size_t rawSize;
+        std::vector<unsigned char> contents;
+    };
+
+    static uint64_t align(uint64_t offset)
+    {
+        return (offset + ResourcePack::EntryAlignment - 1) / ResourcePack::EntryAlignment * ResourcePack::EntryAlignment;
+    }
+
+    std::mutex mutex;
+    std::vector<File> files;
+    size_t rawBytes = 0;
+    size_t storedBytes = 0;
+};
+#endif
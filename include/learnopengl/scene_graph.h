@@ -0,0 +1,317 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/json.h>
+#include <learnopengl/object_transforms.h>
+#include <learnopengl/virtual_file_system.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Hierarchy of placed objects, loaded from a scene file so objects can be added or moved without recompiling.
+//
+// Nodes live in parallel arrays (structure of arrays) in an order where every parent precedes its children, so world
+// matrices are brought up to date by one forward pass that reads each parent's result before its children need it. Only
+// nodes whose local transform changed, and their descendants, are recomputed, and the pass is skipped entirely when
+// nothing moved. The hot arrays hold only what the pass touches; names and model paths are kept apart.
+//
+//     SceneGraph scene;
+//     SceneGraph::Load("resources/scenes/hollow_knight.json", scene);
+//     ...
+//     scene.SetPosition(node, position);
+//     scene.UpdateWorld(transforms);      // once per frame, before drawing
+//     scene.ForEachDrawable([&](unsigned int object, int model) { ... });
+class SceneGraph
+{
+public:
+    enum { NoParent = -1, NoModel = -1, NoObject = -1 };
+
+    // appends a node under parent, which must already exist; model is an index from AddModel, or NoModel
+    int AddNode(const std::string &name, int parent = NoParent, const glm::vec3 &position = glm::vec3(0.0f),
+                const glm::mat3 &rotation = glm::mat3(1.0f), const glm::vec3 &scale = glm::vec3(1.0f), int model = NoModel)
+    {
+        int index = (int) parents.size();
+        parents.push_back(parent >= 0 && parent < index ? parent : (int) NoParent);
+        positions.push_back(position);
+        rotations.push_back(rotation);
+        scales.push_back(scale);
+        worlds.push_back(glm::mat4(1.0f));
+        dirty.push_back(1);
+        models.push_back(model);
+        objects.push_back((int) NoObject);
+        names.push_back(name);
+        markDirty(index);
+        drawOrderValid = false;
+        return index;
+    }
+
+    // a model file drawn by the nodes that refer to it; the same path always gives the same index
+    int AddModel(const std::string &path)
+    {
+        for (size_t i = 0; i < modelPaths.size(); i++)
+            if (modelPaths[i] == path)
+                return (int) i;
+        modelPaths.push_back(path);
+        drawOrderValid = false;
+        return (int) modelPaths.size() - 1;
+    }
+
+    // first node called name, or -1
+    int Find(const std::string &name) const
+    {
+        for (size_t i = 0; i < names.size(); i++)
+            if (names[i] == name)
+                return (int) i;
+        return -1;
+    }
+
+    int NodeCount() const { return (int) parents.size(); }
+    int ModelCount() const { return (int) modelPaths.size(); }
+    const std::string &Name(int node) const { return names[node]; }
+    const std::string &ModelPath(int model) const { return modelPaths[model]; }
+    int Parent(int node) const { return parents[node]; }
+    int Model(int node) const { return models[node]; }
+
+    // local transform, relative to the parent: translate(position) * rotation * scale(scale)
+    const glm::vec3 &Position(int node) const { return positions[node]; }
+    const glm::mat3 &Rotation(int node) const { return rotations[node]; }
+    const glm::vec3 &Scale(int node) const { return scales[node]; }
+
+    void SetPosition(int node, const glm::vec3 &position)
+    {
+        if (positions[node] == position)
+            return;
+        positions[node] = position;
+        markDirty(node);
+    }
+
+    void SetRotation(int node, const glm::mat3 &rotation)
+    {
+        rotations[node] = rotation;
+        markDirty(node);
+    }
+
+    void SetScale(int node, const glm::vec3 &scale)
+    {
+        if (scales[node] == scale)
+            return;
+        scales[node] = scale;
+        markDirty(node);
+    }
+
+    // as of the last UpdateWorld()
+    const glm::mat4 &World(int node) const { return worlds[node]; }
+    glm::vec3 WorldPosition(int node) const { return glm::vec3(worlds[node][3]); }
+
+    // largest factor the node's world matrix scales by along any of its axes
+    float WorldScale(int node) const
+    {
+        const glm::mat4 &world = worlds[node];
+        return std::max(std::max(glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1]))),
+                        glm::length(glm::vec3(world[2])));
+    }
+
+    // recomputes the world matrices of moved nodes and their descendants and hands those of drawn nodes to transforms,
+    // giving nodes that draw a model their object there the first time
+    void UpdateWorld(ObjectTransforms &transforms)
+    {
+        if (firstDirty >= parents.size())
+            return;
+        size_t count = parents.size();
+        for (size_t i = firstDirty; i < count; i++)
+        {
+            int parent = parents[i];
+            if (!dirty[i] && (parent == NoParent || !dirty[parent]))
+                continue;
+            dirty[i] = 1;       // so the children below recompute too
+            glm::mat4 local = localMatrix(i);
+            worlds[i] = parent == NoParent ? local : worlds[parent] * local;
+            if (models[i] == NoModel)
+                continue;
+            if (objects[i] == NoObject)
+                objects[i] = (int) transforms.Add();
+            transforms.Set(objects[i], worlds[i]);
+        }
+        memset(&dirty[firstDirty], 0, count - firstDirty);
+        firstDirty = count;
+    }
+
+    // calls draw(object, model) for every node with a model, grouped by model so consecutive draws share their buffers
+    // and textures; object is the node's index in the ObjectTransforms given to UpdateWorld()
+    template<class Draw>
+    void ForEachDrawable(Draw draw) const
+    {
+        updateDrawOrder();
+        for (unsigned int node : drawOrder)
+            if (objects[node] != NoObject)
+                draw((unsigned int) objects[node], models[node]);
+    }
+
+    // world position of model's instance nearest to point, as of the last UpdateWorld(); for distance-based streaming of
+    // models drawn more than once
+    glm::vec3 NearestInstance(int model, const glm::vec3 &point) const
+    {
+        updateDrawOrder();
+        glm::vec3 nearest(0.0f);
+        float best = -1.0f;
+        for (unsigned int i = modelFirst[model]; i < modelFirst[model + 1]; i++)
+        {
+            glm::vec3 position = WorldPosition(drawOrder[i]);
+            float distance = glm::length(position - point);
+            if (best < 0.0f || distance < best)
+            {
+                best = distance;
+                nearest = position;
+            }
+        }
+        return nearest;
+    }
+
+    // largest world scale among the nodes drawing model
+    float ModelScale(int model) const
+    {
+        updateDrawOrder();
+        float scale = 0.0f;
+        for (unsigned int i = modelFirst[model]; i < modelFirst[model + 1]; i++)
+            scale = std::max(scale, WorldScale(drawOrder[i]));
+        return scale;
+    }
+
+    // Reads a scene file into scene, appending to what it holds:
+    //
+    //     {
+    //         "texturePrefix": "material.",
+    //         "nodes": [
+    //             {"name": "door", "model": "resources/objects/wooden_door/scene.gltf", "position": [54, 76, 5],
+    //              "rotate": [[90, 0, 1, 0], [90, 1, 0, 0]], "scale": 20},
+    //             {"name": "ghost", "position": [-5, 9.5, -8], "children": [
+    //                 {"name": "grimmchild", "model": "...", "rotate": [[45, 0, 1, 0]], "scale": 11}
+    //             ]}
+    //         ]
+    //     }
+    //
+    // "rotate" lists rotations as [degrees, axis x, y, z], outermost first; "scale" is a number or an [x, y, z] array.
+    // Every key of a node is optional. Returns false, leaving scene unchanged, if the file is missing or malformed.
+    static bool Load(const std::string &path, SceneGraph &scene)
+    {
+        FileView file = VirtualFileSystem::Instance().Open(path);
+        JsonValue document;
+        if (!file || !JsonValue::Parse(file.String(), document) || document["nodes"].type != JsonValue::ArrayValue)
+        {
+            std::cout << "ERROR::SCENE:: could not read scene file " << path << std::endl;
+            return false;
+        }
+        SceneGraph loaded = scene;
+        if (document.Has("texturePrefix"))
+            loaded.texturePrefix = document["texturePrefix"].String();
+        const JsonValue &nodes = document["nodes"];
+        for (size_t i = 0; i < nodes.Size(); i++)
+            if (!loaded.loadNode(nodes[i], NoParent, 0))
+            {
+                std::cout << "ERROR::SCENE:: malformed node " << i << " in " << path << std::endl;
+                return false;
+            }
+        scene = std::move(loaded);
+        return true;
+    }
+
+    // sampler name prefix the scene's models are drawn with, see Model::SetShaderTextureNamePrefix
+    const std::string &TexturePrefix() const { return texturePrefix; }
+
+private:
+    static const int MaxDepth = 64;
+
+    // nodes with a model sorted by model, the instances of model m being drawOrder[modelFirst[m]] up to modelFirst[m + 1]
+    void updateDrawOrder() const
+    {
+        if (drawOrderValid)
+            return;
+        drawOrder.clear();
+        modelFirst.assign(modelPaths.size() + 1, 0);
+        for (size_t i = 0; i < models.size(); i++)
+            if (models[i] != NoModel)
+            {
+                drawOrder.push_back((unsigned int) i);
+                modelFirst[models[i] + 1]++;
+            }
+        std::stable_sort(drawOrder.begin(), drawOrder.end(), [this](unsigned int a, unsigned int b) {
+            return models[a] < models[b];
+        });
+        for (size_t m = 1; m < modelFirst.size(); m++)
+            modelFirst[m] += modelFirst[m - 1];
+        drawOrderValid = true;
+    }
+
+    void markDirty(int node)
+    {
+        dirty[node] = 1;
+        firstDirty = std::min(firstDirty, (size_t) node);
+    }
+
+    glm::mat4 localMatrix(size_t i) const
+    {
+        const glm::mat3 &rotation = rotations[i];
+        const glm::vec3 &scale = scales[i];
+        return glm::mat4(glm::vec4(rotation[0] * scale.x, 0.0f), glm::vec4(rotation[1] * scale.y, 0.0f),
+                         glm::vec4(rotation[2] * scale.z, 0.0f), glm::vec4(positions[i], 1.0f));
+    }
+
+    static glm::vec3 vector(const JsonValue &value, const glm::vec3 &fallback)
+    {
+        if (value.type == JsonValue::NumberValue)
+            return glm::vec3((float) value.Number());
+        if (value.Size() != 3)
+            return fallback;
+        return glm::vec3((float) value[0].Number(), (float) value[1].Number(), (float) value[2].Number());
+    }
+
+    bool loadNode(const JsonValue &node, int parent, int depth)
+    {
+        if (node.type != JsonValue::ObjectValue || depth > MaxDepth)
+            return false;
+        glm::mat4 rotation(1.0f);
+        const JsonValue &rotate = node["rotate"];
+        for (size_t i = 0; i < rotate.Size(); i++)
+        {
+            const JsonValue &step = rotate[i];
+            glm::vec3 axis((float) step[1].Number(), (float) step[2].Number(), (float) step[3].Number());
+            if (step.Size() != 4 || glm::length(axis) == 0.0f)
+                return false;
+            rotation = glm::rotate(rotation, glm::radians((float) step[0].Number()), axis);
+        }
+        int model = node.Has("model") ? AddModel(node["model"].String()) : NoModel;
+        int index = AddNode(node["name"].String(), parent, vector(node["position"], glm::vec3(0.0f)), glm::mat3(rotation),
+                            vector(node["scale"], glm::vec3(1.0f)), model);
+        const JsonValue &children = node["children"];
+        for (size_t i = 0; i < children.Size(); i++)
+            if (!loadNode(children[i], index, depth + 1))
+                return false;
+        return true;
+    }
+
+    // hot: read or written by UpdateWorld
+    std::vector<int> parents;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::mat3> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> worlds;
+    std::vector<unsigned char> dirty;
+    std::vector<int> models;
+    std::vector<int> objects;       // in the ObjectTransforms, for nodes with a model
+    size_t firstDirty = 0;          // no node before it is dirty
+
+    // cold
+    std::vector<std::string> names;
+    std::vector<std::string> modelPaths;
+    std::string texturePrefix;
+    mutable std::vector<unsigned int> drawOrder;
+    mutable std::vector<unsigned int> modelFirst;
+    mutable bool drawOrderValid = false;
+};
+#endif
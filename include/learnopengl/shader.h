@@ -4,18 +4,54 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/load_profiler.h>
+#include <learnopengl/uniform_buffer.h>
+#include <learnopengl/virtual_file_system.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
+#include <utility>
+#include <vector>
 #include <common.h>
+
+// Name of a uniform, identified by its 64-bit FNV-1a hash. A literal converts through a constexpr constructor, but a
+// temporary made at the call site is only folded if the optimizer chooses to, so names set every frame are kept as
+// constexpr ids, which are hashed at compile time. Names built at runtime convert from std::string; make those once and
+// keep them too:
+//
+//     static constexpr UniformId Exposure("exposure");
+//     std::vector<UniformId> lights;   // e.g. "pointLight[" + std::to_string(i) + "].position", built at startup
+struct UniformId {
+    uint64_t hash;
+
+    template<size_t N>
+    constexpr UniformId(const char (&name)[N]) : hash(Hash(name, N - 1)) {}
+    UniformId(const std::string &name) : hash(Hash(name.data(), name.size())) {}
+
+    static constexpr uint64_t Hash(const char *name, size_t length)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash ^= (unsigned char) name[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+};
+
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly; defines, e.g. "#define N 4\n", are inserted after the #version line of
+    // every stage, for constants the C++ side owns
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
+           const std::string &defines = std::string())
     {
         std::string vertexPathString(vertexPath);
         std::string fragmentPathString(fragmentPath);
@@ -26,76 +62,65 @@ public:
         std::string vertexCode;
         std::string fragmentCode;
         std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-            // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
-            {
-                std::string geometryPathString(geometryPath);
-                geometryPath = geometryPathString.c_str();
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
-        }
-        catch (std::ifstream::failure& e)
+        // files come from the resource pack when one is mounted, see VirtualFileSystem
+        FileView vShaderFile = VirtualFileSystem::Instance().Open(vertexPath);
+        FileView fShaderFile = VirtualFileSystem::Instance().Open(fragmentPath);
+        FileView gShaderFile;
+        // if geometry shader path is present, also load a geometry shader
+        if(geometryPath != nullptr)
+            gShaderFile = VirtualFileSystem::Instance().Open(geometryPath);
+        if (!vShaderFile || !fShaderFile || (geometryPath != nullptr && !gShaderFile))
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
+        // convert views into strings
+        vertexCode = withDefines(vShaderFile.String(), defines);
+        fragmentCode = withDefines(fShaderFile.String(), defines);
+        geometryCode = withDefines(gShaderFile.String(), defines);
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
+        {
+            LoadProfiler::Scope timer(vertexPath, LoadProfiler::Compile, vertexCode.size(), true);
+            vertex = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(vertex, 1, &vShaderCode, NULL);
+            glCompileShader(vertex);
+            checkCompileErrors(vertex, "VERTEX");
+        }
         // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
+        {
+            LoadProfiler::Scope timer(fragmentPath, LoadProfiler::Compile, fragmentCode.size(), true);
+            fragment = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(fragment, 1, &fShaderCode, NULL);
+            glCompileShader(fragment);
+            checkCompileErrors(fragment, "FRAGMENT");
+        }
         // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
+        unsigned int geometry = 0;
         if(geometryPath != nullptr)
         {
             const char * gShaderCode = geometryCode.c_str();
+            LoadProfiler::Scope timer(geometryPath, LoadProfiler::Compile, geometryCode.size(), true);
             geometry = glCreateShader(GL_GEOMETRY_SHADER);
             glShaderSource(geometry, 1, &gShaderCode, NULL);
             glCompileShader(geometry);
             checkCompileErrors(geometry, "GEOMETRY");
         }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+        // shader Program, reported under the vertex shader's path
+        {
+            LoadProfiler::Scope timer(vertexPath, LoadProfiler::Link, 0, true);
+            ID = glCreateProgram();
+            glAttachShader(ID, vertex);
+            glAttachShader(ID, fragment);
+            if(geometryPath != nullptr)
+                glAttachShader(ID, geometry);
+            glLinkProgram(ID);
+            checkCompileErrors(ID, "PROGRAM");
+            reflectUniforms();
+            bindUniformBlocks();
+        }
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -109,66 +134,194 @@ public:
     { 
         glUseProgram(ID); 
     }
-    // utility uniform functions
+    // utility uniform functions; a name is hashed, at compile time for literals, and looked up in the table reflected at
+    // link time. Values equal to the one last set on the uniform are not sent again. Uniforms the program doesn't use
+    // are ignored.
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(UniformId name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        setInt(name, (int)value);
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(UniformId name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        if (const Uniform *uniform = changed(name, &value, sizeof(value)))
+            glUniform1i(uniform->location, value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(UniformId name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        if (const Uniform *uniform = changed(name, &value, sizeof(value)))
+            glUniform1f(uniform->location, value);
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setVec2(UniformId name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        if (const Uniform *uniform = changed(name, &value[0], sizeof(value)))
+            glUniform2fv(uniform->location, 1, &value[0]);
     }
-    void setVec2(const std::string &name, float x, float y) const
+    void setVec2(UniformId name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        setVec2(name, glm::vec2(x, y));
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(UniformId name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        if (const Uniform *uniform = changed(name, &value[0], sizeof(value)))
+            glUniform3fv(uniform->location, 1, &value[0]);
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(UniformId name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        setVec3(name, glm::vec3(x, y, z));
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(UniformId name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        if (const Uniform *uniform = changed(name, &value[0], sizeof(value)))
+            glUniform4fv(uniform->location, 1, &value[0]);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
+    void setVec4(UniformId name, float x, float y, float z, float w) const
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        setVec4(name, glm::vec4(x, y, z, w));
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(UniformId name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        if (const Uniform *uniform = changed(name, &mat[0][0], sizeof(mat)))
+            glUniformMatrix2fv(uniform->location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(UniformId name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        if (const Uniform *uniform = changed(name, &mat[0][0], sizeof(mat)))
+            glUniformMatrix3fv(uniform->location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(UniformId name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        if (const Uniform *uniform = changed(name, &mat[0][0], sizeof(mat)))
+            glUniformMatrix4fv(uniform->location, 1, GL_FALSE, &mat[0][0]);
+    }
+
+    // whether the program has an active uniform of that name
+    bool hasUniform(UniformId name) const
+    {
+        return find(name) != nullptr;
     }
 
 private:
+    // one active uniform, or array element, of the program, with the value it was last set to
+    struct Uniform {
+        uint64_t id = 0;            // UniformId hash; 0 marks a free slot
+        GLint location = -1;
+        unsigned char size = 0;     // bytes of value; 0 until the uniform is first set
+        alignas(4) unsigned char value[sizeof(glm::mat4)];
+    };
+
+    // open-addressed table with power-of-two capacity, at most half full; the cached values change in const set calls
+    mutable std::vector<Uniform> uniforms;
+
+    Uniform *find(UniformId name) const
+    {
+        if (uniforms.empty())
+            return nullptr;
+        size_t mask = uniforms.size() - 1;
+        for (size_t i = name.hash & mask; uniforms[i].id != 0; i = (i + 1) & mask)
+            if (uniforms[i].id == name.hash)
+                return &uniforms[i];
+        return nullptr;
+    }
+
+    // the uniform if value differs from the one it holds, after recording value as its new one; nullptr otherwise
+    const Uniform *changed(UniformId name, const void *value, size_t size) const
+    {
+        Uniform *uniform = find(name);
+        if (!uniform || (uniform->size == size && memcmp(uniform->value, value, size) == 0))
+            return nullptr;
+        uniform->size = (unsigned char) size;
+        memcpy(uniform->value, value, size);
+        return uniform;
+    }
+
+    // builds the uniform table from the active uniforms; each element of an array gets its own entry, and the array's bare
+    // name refers to element 0 as in glGetUniformLocation
+    void reflectUniforms()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<std::pair<std::string, GLint>> found;
+        std::vector<GLchar> buffer(maxLength + 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint arraySize = 0;
+            GLenum type;
+            glGetActiveUniform(ID, (GLuint) i, (GLsizei) buffer.size(), &length, &arraySize, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            GLint location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0)       // in a uniform block
+                continue;
+            found.emplace_back(name, location);
+            if (name.size() < 3 || name.compare(name.size() - 3, 3, "[0]") != 0)
+                continue;
+            std::string stem = name.substr(0, name.size() - 3);
+            found.emplace_back(stem, location);
+            for (GLint element = 1; element < arraySize; element++)
+            {
+                std::string elementName = stem + "[" + std::to_string(element) + "]";
+                found.emplace_back(elementName, glGetUniformLocation(ID, elementName.c_str()));
+            }
+        }
+
+        size_t capacity = 16;
+        while (capacity < found.size() * 2)
+            capacity *= 2;
+        uniforms.assign(capacity, Uniform());
+        for (const auto &uniform : found)
+        {
+            UniformId id(uniform.first);
+            size_t mask = capacity - 1, i = id.hash & mask;
+            while (uniforms[i].id != 0 && uniforms[i].id != id.hash)
+                i = (i + 1) & mask;
+            if (uniforms[i].id == id.hash)
+            {
+                std::cout << "ERROR::SHADER::UNIFORM_HASH_COLLISION: " << uniform.first << std::endl;
+                continue;
+            }
+            uniforms[i].id = id.hash;
+            uniforms[i].location = uniform.second;
+        }
+    }
+
+    // points the shared blocks the program declares at their binding points; values in blocks are not in the uniform table
+    void bindUniformBlocks()
+    {
+        for (GLuint binding = 0; binding < UniformBlocks::BindingCount; binding++)
+        {
+            GLuint index = glGetUniformBlockIndex(ID, UniformBlocks::Name((UniformBlocks::Binding) binding));
+            if (index != GL_INVALID_INDEX)
+                glUniformBlockBinding(ID, index, binding);
+        }
+    }
+
+    // code with defines inserted after its #version line, followed by a #line directive so compile errors keep the line
+    // numbers of the file
+    static std::string withDefines(const std::string &code, const std::string &defines)
+    {
+        if (defines.empty())
+            return code;
+        size_t insert = 0;
+        size_t version = code.find("#version");
+        if (version != std::string::npos)
+        {
+            insert = code.find('\n', version);
+            insert = insert == std::string::npos ? code.size() : insert + 1;
+        }
+        int line = 1 + (int) std::count(code.begin(), code.begin() + insert, '\n');
+        return code.substr(0, insert) + defines + "#line " + std::to_string(line) + "\n" + code.substr(insert);
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,178 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <glad/glad.h>
+
+#include <stb_image.h>
+
+#include <learnopengl/hash.h>
+#include <learnopengl/load_profiler.h>
+#include <learnopengl/virtual_file_system.h>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace std;
+
+// one mip level of an image, pointing into ImageData::pixels (level 0 of a decoded image) or ImageData::storage
+struct ImageLevel {
+    int width;
+    int height;
+    const unsigned char *data;
+    size_t size;
+};
+
+// pixels decoded by stb_image, optionally with a mip chain built on the CPU (see texture_mipmap.h), or a cooked
+// block-compressed mip chain (see texture_compress.h); loading is thread-safe, so this is produced on loader threads and
+// uploaded on the GL thread
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    int nrComponents = 0;
+    shared_ptr<unsigned char> pixels;
+    GLenum compressedFormat = 0;        // non-zero for cooked images, which carry levels instead of pixels
+    vector<ImageLevel> levels;          // the full mip chain; empty for decoded images whose mips the GL generates
+    shared_ptr<const void> storage;     // keeps the memory behind levels alive
+    bool normalMap = false;
+    string canonicalPath;       // identity of the source file, see CanonicalPath()
+    uint64_t contentHash = 0;   // hash of the decoded pixels and their dimensions, for deduplicating identical images
+
+    bool HasData() const { return pixels || compressedFormat != 0; }
+
+    // bytes held in memory: the decoded pixels or the mip chain
+    size_t DataBytes() const
+    {
+        if (levels.empty())
+            return pixels ? (size_t) width * height * nrComponents : 0;
+        size_t bytes = 0;
+        for (const ImageLevel &level : levels)
+            bytes += level.size;
+        return bytes;
+    }
+
+    // bytes the texture occupies on the GPU, including its mip chain
+    size_t GpuBytes() const
+    {
+        if (!levels.empty())
+            return DataBytes();
+        // level 0 plus the mip chain the GL generates, which adds roughly a third
+        return (size_t) width * height * nrComponents * 4 / 3;
+    }
+};
+
+ImageData DecodeImage(const string &filename);
+ImageData DecodeImage(const FileView &file);
+void FlipVertically(unsigned char *pixels, int width, int height, int nrComponents);
+GLenum FormatFor(int nrComponents);
+unsigned int TextureFromImage(const ImageData &image, const string &filename, bool gamma = false);
+unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);    // see texture_compress.h
+
+ImageData DecodeImage(const string &filename)
+{
+    return DecodeImage(VirtualFileSystem::Instance().Open(filename));
+}
+
+// decodes an image file already in memory, such as a view into the resource pack
+ImageData DecodeImage(const FileView &file)
+{
+    ImageData image;
+    unsigned char *data = file ? stbi_load_from_memory(file.data, (int) file.size, &image.width, &image.height, &image.nrComponents, 0)
+                               : nullptr;
+    if (data)
+    {
+        image.pixels = shared_ptr<unsigned char>(data, stbi_image_free);
+        int dimensions[3] = {image.width, image.height, image.nrComponents};
+        image.contentHash = HashBytes(dimensions, sizeof(dimensions));
+        image.contentHash = HashContent(data, (size_t) image.width * image.height * image.nrComponents, image.contentHash);
+    }
+    return image;
+}
+
+// stb_image's flip-on-load flag is process-wide, so setting it would race with decoding on loader threads; images that
+// need flipping are flipped here after decoding instead
+void FlipVertically(unsigned char *pixels, int width, int height, int nrComponents)
+{
+    size_t rowBytes = (size_t) width * nrComponents;
+    vector<unsigned char> row(rowBytes);
+    for (int top = 0, bottom = height - 1; top < bottom; top++, bottom--)
+    {
+        memcpy(row.data(), pixels + top * rowBytes, rowBytes);
+        memcpy(pixels + top * rowBytes, pixels + bottom * rowBytes, rowBytes);
+        memcpy(pixels + bottom * rowBytes, row.data(), rowBytes);
+    }
+}
+
+// pixel (and unsized internal) format of tightly packed 8-bit texels with nrComponents channels
+GLenum FormatFor(int nrComponents)
+{
+    if (nrComponents == 1)
+        return GL_RED;
+    if (nrComponents == 2)
+        return GL_RG;
+    if (nrComponents == 3)
+        return GL_RGB;
+    return GL_RGBA;
+}
+
+unsigned int TextureFromImage(const ImageData &image, const string &filename, bool gamma)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    if (image.compressedFormat != 0)
+    {
+        // cooked images bring their own mip chain, so nothing is generated here
+        LoadProfiler::Scope timer(filename, LoadProfiler::Upload, image.DataBytes(), true);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        for (unsigned int level = 0; level < image.levels.size(); level++)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, image.compressedFormat, image.levels[level].width, image.levels[level].height,
+                                   0, (GLsizei) image.levels[level].size, image.levels[level].data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint) image.levels.size() - 1);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else if (image.pixels)
+    {
+        GLenum format = FormatFor(image.nrComponents);
+
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        if (!image.levels.empty())
+        {
+            // mips built on a loader thread: every level is uploaded as it is, rows tightly packed down to 1x1
+            LoadProfiler::Scope timer(filename, LoadProfiler::Upload, image.DataBytes(), true);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (unsigned int level = 0; level < image.levels.size(); level++)
+                glTexImage2D(GL_TEXTURE_2D, level, format, image.levels[level].width, image.levels[level].height, 0, format,
+                             GL_UNSIGNED_BYTE, image.levels[level].data);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint) image.levels.size() - 1);
+        }
+        else
+        {
+            {
+                LoadProfiler::Scope timer(filename, LoadProfiler::Upload, image.DataBytes(), true);
+                glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.get());
+            }
+            LoadProfiler::Scope timer(filename, LoadProfiler::Mipmap, image.GpuBytes() - image.DataBytes(), true);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Texture failed to load at path: " << filename << std::endl;
+    }
+
+    return textureID;
+}
+
+#endif
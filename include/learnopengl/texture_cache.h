@@ -0,0 +1,177 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <learnopengl/gl_handle.h>
+#include <learnopengl/texture.h>
+#include <learnopengl/texture_compress.h>
+#include <learnopengl/texture_streamer.h>
+
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// absolute path with symlinks and ./.. resolved, so the same file reached through different model directories maps to one key
+inline string CanonicalPath(const string &path)
+{
+    char resolved[PATH_MAX];
+    if (realpath(path.c_str(), resolved))
+        return string(resolved);
+    return path;
+}
+
+// Process-wide, reference-counted registry of GL textures shared by every Model. A texture is found in O(1) either by the
+// canonical path of its source file or by the hash of its decoded content, so identical images referenced by different
+// models (or copied under different names) are uploaded once. Textures are uploaded as linear data whatever a model's
+// gammaCorrection (TextureFromImage ignores its gamma flag), so one entry serves every model.
+//
+// Contains() may be called from loader threads to skip decoding; Acquire() and Release() issue GL calls and must run on the
+// GL thread.
+class TextureRegistry
+{
+public:
+    static TextureRegistry &Instance()
+    {
+        static TextureRegistry registry;
+        return registry;
+    }
+
+    bool Contains(const string &canonicalPath)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return byPath.count(canonicalPath) != 0;
+    }
+
+    // returns a referenced texture for image, reusing a resident one with the same canonical path or identical pixels.
+    // image may come without data when the loader skipped loading because the path was resident; if it was released in
+    // the meantime the file is loaded here instead.
+    unsigned int Acquire(const ImageData &image)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const string &key = image.canonicalPath;
+        auto path = byPath.find(key);
+        if (path != byPath.end())
+        {
+            Entry &entry = entries[path->second];
+            entry.refCount++;
+            pathHits++;
+            savedBytes += entry.gpuBytes;
+            return entry.texture.get();
+        }
+
+        ImageData decoded = image.HasData() ? image : LoadTextureImage(image.canonicalPath, image.normalMap
+                                                                       ? TextureCompression::Normal : TextureCompression::Color);
+        decoded.canonicalPath = image.canonicalPath;
+        uint64_t content = decoded.contentHash;
+        auto same = decoded.HasData() ? byContent.find(content) : byContent.end();
+        if (same != byContent.end())
+        {
+            Entry &entry = entries[same->second];
+            entry.refCount++;
+            entry.paths.push_back(key);
+            byPath[key] = entry.texture.get();
+            contentHits++;
+            savedBytes += entry.gpuBytes;
+            return entry.texture.get();
+        }
+
+        Entry entry;
+        // cooked images are small and carry their mips, so they are uploaded directly rather than streamed
+        size_t imageBytes = (size_t) decoded.width * decoded.height * decoded.nrComponents;
+        if (streamer && decoded.pixels && imageBytes > DirectUploadBytes)
+            entry.texture.reset(streamer->Begin(decoded));
+        else
+            entry.texture.reset(TextureFromImage(decoded, decoded.canonicalPath));
+        unsigned int id = entry.texture.get();
+        entry.contentHash = decoded.HasData() ? content : 0;
+        entry.gpuBytes = decoded.GpuBytes();
+        entry.refCount = 1;
+        entry.paths.push_back(key);
+        byPath[key] = id;
+        if (decoded.HasData())
+            byContent[content] = id;
+        uploads++;
+        residentBytes += entry.gpuBytes;
+        entries[id] = std::move(entry);
+        return id;
+    }
+
+    // drops one reference; the texture is deleted once no model uses it
+    void Release(unsigned int id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(id);
+        if (it == entries.end() || --it->second.refCount > 0)
+            return;
+        for (const string &key : it->second.paths)
+            byPath.erase(key);
+        if (it->second.contentHash)
+            byContent.erase(it->second.contentHash);
+        residentBytes -= it->second.gpuBytes;
+        if (streamer)
+            streamer->Cancel(id);
+        entries.erase(it);
+    }
+
+    // deletes every resident texture while the GL context is still current; references released afterwards (e.g. by
+    // models destroyed after glfwTerminate) find nothing left to delete
+    void Shutdown()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        byPath.clear();
+        byContent.clear();
+        residentBytes = 0;
+        streamer = nullptr;
+    }
+
+    // routes uploads of images larger than DirectUploadBytes through streamer; nullptr restores blocking uploads
+    void SetStreamer(TextureStreamer *textureStreamer)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        streamer = textureStreamer;
+    }
+
+    // images up to this size are cheaper to upload in one call than to show a placeholder for
+    static const size_t DirectUploadBytes = 256 * 1024;
+
+    void PrintStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::cout << "TEXTURE_CACHE:: " << entries.size() << " resident textures (" << residentBytes / (1024 * 1024) << " MiB), "
+                  << uploads << " uploads, " << pathHits << " path hits, " << contentHits << " content hits, saved "
+                  << savedBytes / (1024 * 1024) << " MiB of GPU memory" << std::endl;
+    }
+
+    size_t SavedBytes()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return savedBytes;
+    }
+
+private:
+    struct Entry {
+        TextureHandle texture;
+        uint64_t contentHash;
+        size_t gpuBytes;
+        unsigned int refCount;
+        vector<string> paths;
+    };
+
+    TextureRegistry() {}
+
+    std::mutex mutex;
+    unordered_map<unsigned int, Entry> entries;
+    unordered_map<string, unsigned int> byPath;
+    unordered_map<uint64_t, unsigned int> byContent;
+    size_t uploads = 0;
+    size_t pathHits = 0;
+    size_t contentHits = 0;
+    size_t savedBytes = 0;
+    size_t residentBytes = 0;
+    TextureStreamer *streamer = nullptr;
+};
+#endif
@@ -0,0 +1,472 @@
+#ifndef TEXTURE_COMPRESS_H
+#define TEXTURE_COMPRESS_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/hash.h>
+#include <learnopengl/texture.h>
+#include <learnopengl/texture_mipmap.h>
+#include <learnopengl/virtual_file_system.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// S3TC is an extension in core 3.3 (universally exposed on desktop); RGTC (BC4/BC5) is core
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// Block compression of source images into a cooked container with a precomputed, gamma-correct mip chain (see
+// TextureMipmap).
+//
+// The block format follows channel usage:
+//   1 channel               -> BC4 (RGTC1)
+//   normal map              -> BC5 (RGTC2, X/Y only, for a normal-mapping shader to reconstruct Z from)
+//   RGB, or RGBA all opaque -> BC1 (DXT1)
+//   RGBA with real alpha    -> BC3 (DXT5)
+// BC7 is not produced: a mode-searching BC7 encoder is out of scope for this loader, and BC3 covers the alpha-tested maps.
+//
+// Cooked files live in resources/cache/textures and are keyed by the content hash of the source file, so editing a PNG
+// recooks it on the next load.
+namespace TextureCompression {
+
+    enum Usage {
+        Color,
+        Normal
+    };
+
+    // set once on the GL thread by DetectSupport(); loader threads only cook formats the driver can sample
+    inline std::atomic<bool> &S3TCSupported()
+    {
+        static std::atomic<bool> supported(false);
+        return supported;
+    }
+
+    inline void DetectSupport()
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            const char *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+            if (name && (strcmp(name, "GL_EXT_texture_compression_s3tc") == 0 || strcmp(name, "GL_ARB_texture_compression_s3tc") == 0))
+                S3TCSupported() = true;
+        }
+    }
+
+    inline size_t BlockBytes(GLenum format)
+    {
+        return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RED_RGTC1 ? 8 : 16;
+    }
+
+    inline size_t LevelBytes(GLenum format, int width, int height)
+    {
+        return (size_t) ((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+    }
+
+    // ---------------------------------------------------------------------------------------------------------------
+    // block encoders; block is 16 texels of 4 bytes (RGBA), row-major
+
+    inline uint16_t PackRGB565(const int *rgb)
+    {
+        return (uint16_t) (((rgb[0] * 31 + 127) / 255) << 11 | ((rgb[1] * 63 + 127) / 255) << 5 | ((rgb[2] * 31 + 127) / 255));
+    }
+
+    inline void UnpackRGB565(uint16_t packed, int *rgb)
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // BC1 colour block from the inset bounding box of the block colours, always in 4-colour mode
+    inline void EncodeBC1(const unsigned char *block, unsigned char *out)
+    {
+        int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0};
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 3; c++)
+            {
+                lo[c] = std::min(lo[c], (int) block[i * 4 + c]);
+                hi[c] = std::max(hi[c], (int) block[i * 4 + c]);
+            }
+        for (int c = 0; c < 3; c++)
+        {
+            int inset = (hi[c] - lo[c]) >> 4;
+            lo[c] += inset;
+            hi[c] -= inset;
+        }
+        uint16_t c0 = PackRGB565(hi), c1 = PackRGB565(lo);
+        uint32_t indices = 0;
+        if (c0 < c1)
+            std::swap(c0, c1);
+        if (c0 != c1)
+        {
+            int palette[4][3];
+            UnpackRGB565(c0, palette[0]);
+            UnpackRGB565(c1, palette[1]);
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestError = 1 << 30;
+                for (int p = 0; p < 4; p++)
+                {
+                    int dr = block[i * 4] - palette[p][0], dg = block[i * 4 + 1] - palette[p][1], db = block[i * 4 + 2] - palette[p][2];
+                    int error = dr * dr + dg * dg + db * db;
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= (uint32_t) best << (2 * i);
+            }
+        }
+        out[0] = c0 & 0xff;
+        out[1] = c0 >> 8;
+        out[2] = c1 & 0xff;
+        out[3] = c1 >> 8;
+        memcpy(out + 4, &indices, 4);
+    }
+
+    // BC4 block for one channel of the block (channel 0..3), 8-value interpolation mode
+    inline void EncodeBC4(const unsigned char *block, int channel, unsigned char *out)
+    {
+        int lo = 255, hi = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            lo = std::min(lo, (int) block[i * 4 + channel]);
+            hi = std::max(hi, (int) block[i * 4 + channel]);
+        }
+        uint64_t bits = 0;
+        if (hi != lo)
+        {
+            int palette[8];
+            palette[0] = hi;
+            palette[1] = lo;
+            for (int k = 2; k < 8; k++)
+                palette[k] = ((8 - k) * hi + (k - 1) * lo + 3) / 7;
+            for (int i = 0; i < 16; i++)
+            {
+                int value = block[i * 4 + channel];
+                int best = 0, bestError = 1 << 30;
+                for (int k = 0; k < 8; k++)
+                {
+                    int error = std::abs(value - palette[k]);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        best = k;
+                    }
+                }
+                bits |= (uint64_t) best << (3 * i);
+            }
+        }
+        out[0] = (unsigned char) hi;
+        out[1] = (unsigned char) lo;
+        for (int b = 0; b < 6; b++)
+            out[2 + b] = (unsigned char) (bits >> (8 * b));
+    }
+
+    inline void EncodeBlock(GLenum format, const unsigned char *block, unsigned char *out)
+    {
+        switch (format)
+        {
+            case GL_COMPRESSED_RED_RGTC1:
+                EncodeBC4(block, 0, out);
+                break;
+            case GL_COMPRESSED_RG_RGTC2:
+                EncodeBC4(block, 0, out);
+                EncodeBC4(block, 1, out + 8);
+                break;
+            case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                EncodeBC4(block, 3, out);
+                EncodeBC1(block, out + 8);
+                break;
+            default:
+                EncodeBC1(block, out);
+                break;
+        }
+    }
+
+    // ---------------------------------------------------------------------------------------------------------------
+    // cooking
+
+    // RGBA8 copy of one level, so every encoder reads the same texel layout
+    inline vector<unsigned char> ExpandToRGBA(const ImageLevel &level, int nrComponents)
+    {
+        vector<unsigned char> rgba((size_t) level.width * level.height * 4);
+        const unsigned char *src = level.data;
+        for (size_t i = 0; i < (size_t) level.width * level.height; i++)
+        {
+            const unsigned char *texel = src + i * nrComponents;
+            unsigned char *dst = &rgba[i * 4];
+            switch (nrComponents)
+            {
+                case 1: dst[0] = dst[1] = dst[2] = texel[0]; dst[3] = 255; break;
+                case 2: dst[0] = dst[1] = dst[2] = texel[0]; dst[3] = texel[1]; break;
+                case 3: dst[0] = texel[0]; dst[1] = texel[1]; dst[2] = texel[2]; dst[3] = 255; break;
+                default: memcpy(dst, texel, 4); break;
+            }
+        }
+        return rgba;
+    }
+
+    inline void CompressLevel(GLenum format, const vector<unsigned char> &rgba, int width, int height, vector<unsigned char> &out)
+    {
+        size_t offset = out.size();
+        out.resize(offset + LevelBytes(format, width, height));
+        unsigned char block[64];
+        for (int by = 0; by < height; by += 4)
+            for (int bx = 0; bx < width; bx += 4)
+            {
+                for (int y = 0; y < 4; y++)
+                    for (int x = 0; x < 4; x++)
+                    {
+                        int sx = std::min(bx + x, width - 1), sy = std::min(by + y, height - 1);
+                        memcpy(block + (y * 4 + x) * 4, &rgba[((size_t) sy * width + sx) * 4], 4);
+                    }
+                EncodeBlock(format, block, &out[offset]);
+                offset += BlockBytes(format);
+            }
+    }
+
+    // block format for an image, or 0 if it should stay uncompressed on this driver
+    inline GLenum ChooseFormat(const ImageData &image, const vector<unsigned char> &rgba, Usage usage)
+    {
+        if (usage == Normal)
+            return GL_COMPRESSED_RG_RGTC2;
+        if (image.nrComponents == 1)
+            return GL_COMPRESSED_RED_RGTC1;
+        if (!S3TCSupported())
+            return 0;
+        for (size_t i = 3; i < rgba.size(); i += 4)
+            if (rgba[i] != 255)
+                return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    }
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t format;        // 0: the levels are raw 8-bit texels of components channels
+        uint32_t width;
+        uint32_t height;
+        uint32_t levels;
+        uint32_t usage;
+        uint32_t components;
+        uint64_t sourceHash;
+        uint64_t contentHash;
+    };
+
+    static const uint32_t Version = 2;
+
+    inline std::string CookedPath(const std::string &sourcePath)
+    {
+        std::string name = sourcePath.substr(sourcePath.find_last_of('/') + 1);
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) HashBytes(sourcePath.data(), sourcePath.size()));
+        return "resources/cache/textures/" + name + "-" + hash + ".hktex";
+    }
+
+    // appends every level of image in format (0: raw texels); rgba is level 0 as returned by ExpandToRGBA
+    inline void EncodeLevels(const ImageData &image, GLenum format, const vector<unsigned char> &rgba, vector<unsigned char> &out)
+    {
+        for (size_t i = 0; i < image.levels.size(); i++)
+        {
+            const ImageLevel &level = image.levels[i];
+            if (format == 0)
+                out.insert(out.end(), level.data, level.data + level.size);
+            else
+                CompressLevel(format, i == 0 ? rgba : ExpandToRGBA(level, image.nrComponents), level.width, level.height, out);
+        }
+    }
+
+    // writes header and payload to path under resources/cache/textures, through a temporary file so readers never see
+    // a partial one
+    inline bool WriteContainer(const std::string &path, const Header &header, const vector<unsigned char> &payload)
+    {
+        mkdir("resources", 0755);
+        mkdir("resources/cache", 0755);
+        mkdir("resources/cache/textures", 0755);
+        std::string tempPath = path + ".tmp";
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+        out.close();
+        if (!out || rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            std::cout << "ERROR::TEXTURE_COMPRESS:: could not write " << path << std::endl;
+            remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // whether the levels of a container can be used on this driver; raw levels are rejected where a block format has
+    // become available, so they are recooked
+    inline bool Samplable(const Header &header)
+    {
+        bool s3tc = header.format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || header.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        if (s3tc)
+            return S3TCSupported();
+        if (header.format == 0)
+            return !S3TCSupported() && header.components >= 1 && header.components <= 4;
+        return true;
+    }
+
+    // whether the header describes a mip chain the readers can walk: a non-empty image of a plausible size and between
+    // one level and its full chain, so level 0 always exists
+    inline bool WellFormed(const Header &header)
+    {
+        const uint32_t MaxSize = 65536;
+        if (header.width == 0 || header.height == 0 || header.width > MaxSize || header.height > MaxSize)
+            return false;
+        return header.levels >= 1
+               && header.levels <= (uint32_t) TextureMipmap::LevelCount((int) header.width, (int) header.height);
+    }
+
+    inline int Components(const Header &header)
+    {
+        return header.format == 0 ? (int) header.components : header.format == GL_COMPRESSED_RED_RGTC1 ? 1
+             : header.format == GL_COMPRESSED_RG_RGTC2 ? 2 : header.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ? 4 : 3;
+    }
+
+    inline size_t ContainerLevelBytes(const Header &header, int width, int height)
+    {
+        return header.format == 0 ? (size_t) width * height * header.components : LevelBytes(header.format, width, height);
+    }
+
+    // writes a decoded image with its full mip chain (see TextureMipmap) as the cooked container: block compressed, or
+    // as raw levels when there is no suitable block format on this driver. Returns false if nothing could be written.
+    inline bool Cook(const ImageData &decoded, uint64_t sourceHash, Usage usage, const std::string &cookedPath)
+    {
+        if (!decoded.pixels)
+            return false;
+        ImageData image = decoded;
+        TextureMipmap::Build(image, usage == Color, cookedPath);
+        vector<unsigned char> rgba = ExpandToRGBA(image.levels[0], image.nrComponents);
+        GLenum format = ChooseFormat(image, rgba, usage);
+        vector<unsigned char> levels;
+        EncodeLevels(image, format, rgba, levels);
+
+        Header header = {};
+        memcpy(header.magic, "HKTX", 4);
+        header.version = Version;
+        header.format = format;
+        header.width = image.width;
+        header.height = image.height;
+        header.levels = (uint32_t) image.levels.size();
+        header.usage = usage;
+        header.components = image.nrComponents;
+        header.sourceHash = sourceHash;
+        header.contentHash = image.contentHash;
+        return WriteContainer(cookedPath, header, levels);
+    }
+
+    // reads cooked file contents into image if they match sourceHash/usage and the format can be sampled here
+    inline bool ReadCooked(const FileView &view, uint64_t sourceHash, Usage usage, ImageData &image)
+    {
+        shared_ptr<FileView> file = make_shared<FileView>(view);
+        if (!*file || file->size < sizeof(Header))
+            return false;
+        Header header;
+        memcpy(&header, file->data, sizeof(header));
+        if (memcmp(header.magic, "HKTX", 4) != 0 || header.version != Version || header.sourceHash != sourceHash || header.usage != (uint32_t) usage)
+            return false;
+        if (!WellFormed(header) || !Samplable(header))
+            return false;
+
+        image.width = header.width;
+        image.height = header.height;
+        image.nrComponents = Components(header);
+        image.contentHash = header.contentHash;
+        image.compressedFormat = header.format;
+        image.levels.clear();
+        size_t offset = sizeof(Header);
+        int width = header.width, height = header.height;
+        for (uint32_t level = 0; level < header.levels; level++)
+        {
+            size_t size = ContainerLevelBytes(header, width, height);
+            if (offset + size > file->size)
+                return false;
+            image.levels.push_back(ImageLevel{width, height, file->data + offset, size});
+            offset += size;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        image.storage = file;
+        if (header.format == 0)     // level 0 doubles as the pixels; nothing writes to them
+            image.pixels = shared_ptr<unsigned char>(file, const_cast<unsigned char *>(image.levels[0].data));
+        return true;
+    }
+
+    // maps the cooked file at cookedPath, preferring the resource pack and falling back to a copy recooked since it was built
+    inline bool ReadCooked(const std::string &cookedPath, uint64_t sourceHash, Usage usage, ImageData &image)
+    {
+        const VirtualFileSystem &files = VirtualFileSystem::Instance();
+        return ReadCooked(files.Open(cookedPath), sourceHash, usage, image)
+               || (files.Packed(cookedPath) && ReadCooked(files.OpenLoose(cookedPath), sourceHash, usage, image));
+    }
+}
+
+// Loads the image a texture is created from, with its mip chain: the cooked version when it is up to date, otherwise the
+// source is decoded, its mips are built and the result is cooked for the next run. Thread-safe apart from the first
+// DetectSupport() call.
+ImageData LoadTextureImage(const string &filename, TextureCompression::Usage usage = TextureCompression::Color)
+{
+    FileView source;
+    uint64_t sourceHash = 0;
+    std::string cookedPath = TextureCompression::CookedPath(filename);
+    ImageData image;
+    {
+        LoadProfiler::Scope timer(filename, LoadProfiler::Decode);
+        source = VirtualFileSystem::Instance().Open(filename);
+        if (!source)
+            return DecodeImage(source);
+        sourceHash = HashContent(source.data, source.size);
+        if (TextureCompression::ReadCooked(cookedPath, sourceHash, usage, image))
+        {
+            timer.Bytes(image.DataBytes());
+            return image;
+        }
+        image = DecodeImage(source);
+        timer.Bytes(image.DataBytes());
+    }
+
+    TextureMipmap::Build(image, usage == TextureCompression::Color, filename);
+    LoadProfiler::Scope timer(filename, LoadProfiler::Decode);
+    if (TextureCompression::Cook(image, sourceHash, usage, cookedPath))
+    {
+        ImageData cooked;
+        if (TextureCompression::ReadCooked(cookedPath, sourceHash, usage, cooked))
+            return cooked;
+    }
+    return image;
+}
+
+unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+{
+    string filename = string(path);
+    filename = directory + '/' + filename;
+
+    return TextureFromImage(LoadTextureImage(filename), filename, gamma);
+}
+#endif
@@ -0,0 +1,278 @@
+#ifndef TEXTURE_CUBEMAP_H
+#define TEXTURE_CUBEMAP_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/hash.h>
+#include <learnopengl/load_profiler.h>
+#include <learnopengl/texture.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/texture_compress.h>
+#include <learnopengl/texture_mipmap.h>
+#include <learnopengl/thread_pool.h>
+#include <learnopengl/virtual_file_system.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// six faces of a cubemap, +X -X +Y -Y +Z -Z, each with its full mip chain; levels of a baked cubemap all point into one
+// mapped file
+struct CubemapImage {
+    ImageData faces[6];
+
+    bool HasData() const
+    {
+        for (const ImageData &face : faces)
+            if (face.levels.empty())
+                return false;
+        return true;
+    }
+
+    size_t DataBytes() const
+    {
+        size_t bytes = 0;
+        for (const ImageData &face : faces)
+            bytes += face.DataBytes();
+        return bytes;
+    }
+};
+
+// A cubemap baked into one file under resources/cache/textures: a TextureCompression::Header tagged HKCB, then every mip
+// level with its six faces back to back, block compressed like cooked textures (raw texels where the driver has no
+// suitable format). The mips are built gamma-correct (see TextureMipmap) and the faces are stored flipped the way the
+// skybox samples them. The file is keyed by the content of the face images, so editing one rebakes the whole cubemap on
+// the next load.
+namespace TextureCubemap {
+
+    // named after the faces' canonical paths in order, so the same six files always map to the same baked file
+    inline std::string BakedPath(const std::vector<std::string> &faces)
+    {
+        uint64_t hash = HashBytes("cubemap", 7);
+        for (const std::string &face : faces)
+        {
+            std::string canonical = CanonicalPath(face);
+            hash = HashBytes(canonical.data(), canonical.size() + 1, hash);
+        }
+        char name[17];
+        snprintf(name, sizeof(name), "%016llx", (unsigned long long) hash);
+        return std::string("resources/cache/textures/cubemap-") + name + ".hkcube";
+    }
+
+    // content hash of the face images, or 0 if one is missing
+    inline uint64_t HashSources(const std::vector<std::string> &faces)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (const std::string &face : faces)
+        {
+            FileView source = VirtualFileSystem::Instance().Open(face);
+            if (!source)
+                return 0;
+            hash = HashContent(source.data, source.size, hash);
+        }
+        return hash;
+    }
+
+    inline bool ReadBaked(const FileView &view, uint64_t sourceHash, CubemapImage &image)
+    {
+        using namespace TextureCompression;
+        shared_ptr<FileView> file = make_shared<FileView>(view);
+        if (!*file || file->size < sizeof(Header))
+            return false;
+        Header header;
+        memcpy(&header, file->data, sizeof(header));
+        if (memcmp(header.magic, "HKCB", 4) != 0 || header.version != Version || header.sourceHash != sourceHash
+            || !WellFormed(header) || !Samplable(header))
+            return false;
+
+        size_t offset = sizeof(Header);
+        int width = header.width, height = header.height;
+        for (uint32_t level = 0; level < header.levels; level++)
+        {
+            size_t size = ContainerLevelBytes(header, width, height);
+            if (offset + 6 * size > file->size)
+                return false;
+            for (ImageData &face : image.faces)
+            {
+                face.levels.push_back(ImageLevel{width, height, file->data + offset, size});
+                offset += size;
+            }
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        for (ImageData &face : image.faces)
+        {
+            face.width = header.width;
+            face.height = header.height;
+            face.nrComponents = Components(header);
+            face.compressedFormat = header.format;
+            face.storage = file;
+            if (header.format == 0)     // level 0 doubles as the pixels; nothing writes to them
+                face.pixels = shared_ptr<unsigned char>(file, const_cast<unsigned char *>(face.levels[0].data));
+        }
+        return true;
+    }
+
+    // maps the baked file at bakedPath, preferring the resource pack and falling back to a copy rebaked since it was built
+    inline bool ReadBaked(const std::string &bakedPath, uint64_t sourceHash, CubemapImage &image)
+    {
+        const VirtualFileSystem &files = VirtualFileSystem::Instance();
+        if (ReadBaked(files.Open(bakedPath), sourceHash, image))
+            return true;
+        image = CubemapImage();
+        return files.Packed(bakedPath) && ReadBaked(files.OpenLoose(bakedPath), sourceHash, image);
+    }
+
+    // decodes the faces in parallel, flips them and builds their mips; false if one is missing or they differ in size or
+    // channels
+    inline bool Decode(const std::vector<std::string> &faces, CubemapImage &image)
+    {
+        ThreadPool::Instance().ParallelFor(6, [&faces, &image](size_t i) {
+            ImageData &face = image.faces[i];
+            {
+                LoadProfiler::Scope timer(faces[i], LoadProfiler::Decode);
+                face = DecodeImage(faces[i]);
+                timer.Bytes(face.DataBytes());
+            }
+            if (!face.pixels)
+                return;
+            FlipVertically(face.pixels.get(), face.width, face.height, face.nrComponents);
+            TextureMipmap::Build(face, true, faces[i]);
+        });
+        for (int i = 0; i < 6; i++)
+        {
+            const ImageData &face = image.faces[i];
+            if (!face.pixels)
+            {
+                std::cout << "Cubemap tex failed to load at path: " << faces[i] << std::endl;
+                return false;
+            }
+            if (face.width != face.height || face.width != image.faces[0].width || face.nrComponents != image.faces[0].nrComponents)
+            {
+                std::cout << "ERROR::CUBEMAP:: faces must be square and match in size and channels: " << faces[i] << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // block compresses the decoded faces, all in one format, and writes them as the baked cubemap
+    inline bool Bake(const CubemapImage &image, uint64_t sourceHash, const std::string &bakedPath)
+    {
+        using namespace TextureCompression;
+        vector<unsigned char> rgba[6];
+        GLenum format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        for (int i = 0; i < 6; i++)
+        {
+            rgba[i] = ExpandToRGBA(image.faces[i].levels[0], image.faces[i].nrComponents);
+            GLenum faceFormat = ChooseFormat(image.faces[i], rgba[i], Color);
+            if (faceFormat == 0 || format == 0)
+                format = 0;
+            else if (faceFormat != GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+                format = faceFormat;
+        }
+        vector<unsigned char> encoded[6];
+        ThreadPool::Instance().ParallelFor(6, [&](size_t i) { EncodeLevels(image.faces[i], format, rgba[i], encoded[i]); });
+
+        // EncodeLevels gives each face's chain in one buffer; the file interleaves them level by level
+        const ImageData &first = image.faces[0];
+        Header header = {};
+        memcpy(header.magic, "HKCB", 4);
+        header.version = Version;
+        header.format = format;
+        header.width = first.width;
+        header.height = first.height;
+        header.levels = (uint32_t) first.levels.size();
+        header.usage = Color;
+        header.components = first.nrComponents;
+        header.sourceHash = sourceHash;
+        vector<unsigned char> payload;
+        size_t offsets[6] = {};
+        for (const ImageLevel &level : first.levels)
+        {
+            size_t size = ContainerLevelBytes(header, level.width, level.height);
+            for (int i = 0; i < 6; i++)
+            {
+                payload.insert(payload.end(), encoded[i].begin() + offsets[i], encoded[i].begin() + offsets[i] + size);
+                offsets[i] += size;
+            }
+        }
+        return WriteContainer(bakedPath, header, payload);
+    }
+}
+
+// Loads a cubemap from six face images: the baked file when it is up to date, otherwise the faces are decoded in parallel
+// and baked for the next run. Thread-safe; returns an image without data if a face is missing.
+CubemapImage LoadCubemapImage(const std::vector<std::string> &faces)
+{
+    CubemapImage image;
+    if (faces.size() != 6)
+    {
+        std::cout << "ERROR::CUBEMAP:: expected 6 faces, got " << faces.size() << std::endl;
+        return image;
+    }
+    std::string bakedPath = TextureCubemap::BakedPath(faces);
+    uint64_t sourceHash;
+    {
+        LoadProfiler::Scope timer(bakedPath, LoadProfiler::Decode);
+        sourceHash = TextureCubemap::HashSources(faces);
+        if (sourceHash != 0 && TextureCubemap::ReadBaked(bakedPath, sourceHash, image))
+        {
+            timer.Bytes(image.DataBytes());
+            return image;
+        }
+    }
+
+    image = CubemapImage();
+    if (!TextureCubemap::Decode(faces, image))
+        return CubemapImage();
+    LoadProfiler::Scope timer(bakedPath, LoadProfiler::Decode);
+    CubemapImage baked;
+    if (TextureCubemap::Bake(image, sourceHash, bakedPath) && TextureCubemap::ReadBaked(bakedPath, sourceHash, baked))
+        return baked;
+    return image;
+}
+
+// creates the cubemap texture with every mip level; one pass per level uploads its six faces from consecutive memory
+unsigned int CubemapFromImage(const CubemapImage &image, const std::string &name)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    if (!image.HasData())
+    {
+        std::cout << "Cubemap tex failed to load: " << name << std::endl;
+        return textureID;
+    }
+
+    const ImageData &first = image.faces[0];
+    GLenum format = FormatFor(first.nrComponents);
+    {
+        LoadProfiler::Scope timer(name, LoadProfiler::Upload, image.DataBytes(), true);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (unsigned int level = 0; level < first.levels.size(); level++)
+            for (unsigned int i = 0; i < 6; i++)
+            {
+                const ImageLevel &face = image.faces[i].levels[level];
+                if (first.compressedFormat != 0)
+                    glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, first.compressedFormat, face.width, face.height,
+                                           0, (GLsizei) face.size, face.data);
+                else
+                    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, format, face.width, face.height, 0, format,
+                                 GL_UNSIGNED_BYTE, face.data);
+            }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, (GLint) first.levels.size() - 1);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return textureID;
+}
+#endif
@@ -0,0 +1,186 @@
+#ifndef TEXTURE_MIPMAP_H
+#define TEXTURE_MIPMAP_H
+
+#include <learnopengl/load_profiler.h>
+#include <learnopengl/texture.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+// CPU mip chains for decoded images, built on loader threads so the GL thread uploads finished levels instead of running
+// glGenerateMipmap.
+//
+// Every level is a 2x2 box filter of the one above, odd edges clamped like the cooked chains in texture_compress.h. Colour
+// images are filtered in linear light: their sRGB-encoded channels are decoded through a table, averaged as floats and
+// encoded again, so fine light/dark detail keeps its brightness in the distance instead of darkening as it does when the
+// encoded bytes are averaged. Alpha, single-channel images and normal maps are averaged as they are. Levels below the first
+// are computed from the float level above rather than from its 8-bit copy, so rounding does not build up down the chain.
+namespace TextureMipmap {
+
+    inline float SrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    inline const float *SrgbToLinearTable()
+    {
+        static const std::vector<float> table = []() {
+            std::vector<float> values(256);
+            for (int i = 0; i < 256; i++)
+                values[i] = SrgbToLinear(i / 255.0f);
+            return values;
+        }();
+        return table.data();
+    }
+
+    // linear values in [0, 1] quantized to 16 bits map to their sRGB byte; fine enough that the darkest codes stay apart
+    inline const unsigned char *LinearToSrgbTable()
+    {
+        static const std::vector<unsigned char> table = []() {
+            std::vector<unsigned char> values(65536);
+            for (int i = 0; i < 65536; i++)
+            {
+                float linear = i / 65535.0f;
+                float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+                values[i] = (unsigned char) std::min(255.0f, encoded * 255.0f + 0.5f);
+            }
+            return values;
+        }();
+        return table.data();
+    }
+
+    // channels of a texel that hold sRGB-encoded colour: RGB, or the grey of a grey/alpha image
+    inline int SrgbChannels(int nrComponents, bool colour)
+    {
+        if (!colour || nrComponents < 2)
+            return 0;
+        return nrComponents == 2 ? 1 : 3;
+    }
+
+    // one row of 8-bit texels to linear RGBA floats
+    inline void DecodeRow(const unsigned char *src, int width, int nrComponents, int srgbChannels, float *out)
+    {
+        const float *toLinear = SrgbToLinearTable();
+        for (int x = 0; x < width; x++)
+        {
+            for (int c = 0; c < nrComponents; c++)
+                out[x * 4 + c] = c < srgbChannels ? toLinear[src[x * nrComponents + c]] : src[x * nrComponents + c] / 255.0f;
+            for (int c = nrComponents; c < 4; c++)
+                out[x * 4 + c] = 0.0f;
+        }
+    }
+
+    // linear RGBA floats back to 8-bit texels with nrComponents channels
+    inline void EncodeTexels(const float *texels, size_t count, int nrComponents, int srgbChannels, unsigned char *out)
+    {
+        const unsigned char *toSrgb = LinearToSrgbTable();
+        for (size_t i = 0; i < count; i++)
+            for (int c = 0; c < nrComponents; c++)
+            {
+                float value = std::min(1.0f, std::max(0.0f, texels[i * 4 + c]));
+                out[i * nrComponents + c] = c < srgbChannels ? toSrgb[(int) (value * 65535.0f + 0.5f)]
+                                                             : (unsigned char) (value * 255.0f + 0.5f);
+            }
+    }
+
+    // averages 2x2 blocks of two RGBA float rows of width texels into one row of outWidth texels
+    inline void DownsampleRows(const float *row0, const float *row1, int width, int outWidth, float *out)
+    {
+#ifdef __SSE2__
+        const __m128 quarter = _mm_set1_ps(0.25f);
+        for (int x = 0; x < outWidth; x++)
+        {
+            int x0 = std::min(2 * x, width - 1) * 4, x1 = std::min(2 * x + 1, width - 1) * 4;
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+                                    _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+            _mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, quarter));
+        }
+#else
+        for (int x = 0; x < outWidth; x++)
+        {
+            int x0 = std::min(2 * x, width - 1) * 4, x1 = std::min(2 * x + 1, width - 1) * 4;
+            for (int c = 0; c < 4; c++)
+                out[x * 4 + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+        }
+#endif
+    }
+
+    inline int LevelCount(int width, int height)
+    {
+        int levels = 1;
+        while (width > 1 || height > 1)
+        {
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+            levels++;
+        }
+        return levels;
+    }
+
+    // fills image.levels with the full chain down to 1x1, level 0 being the decoded pixels; colour says whether the image
+    // holds sRGB colour (as opposed to normals or other data). Does nothing for cooked images or ones that already have mips.
+    inline void Build(ImageData &image, bool colour, const std::string &name)
+    {
+        if (!image.pixels || image.compressedFormat != 0 || !image.levels.empty())
+            return;
+        LoadProfiler::Scope timer(name, LoadProfiler::Mipmap);
+        int components = image.nrComponents;
+        int srgbChannels = SrgbChannels(components, colour);
+        int levelCount = LevelCount(image.width, image.height);
+
+        size_t chainBytes = 0;
+        for (int level = 1, width = image.width, height = image.height; level < levelCount; level++)
+        {
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+            chainBytes += (size_t) width * height * components;
+        }
+        std::shared_ptr<std::vector<unsigned char>> storage = std::make_shared<std::vector<unsigned char>>(chainBytes);
+        image.levels.push_back(ImageLevel{image.width, image.height, image.pixels.get(), (size_t) image.width * image.height * components});
+
+        // level 1 straight from the 8-bit pixels, two decoded rows at a time; the rest from the float level above
+        int width = image.width, height = image.height;
+        int outWidth = std::max(1, width / 2), outHeight = std::max(1, height / 2);
+        std::vector<float> current((size_t) outWidth * outHeight * 4);
+        std::vector<float> row0((size_t) width * 4), row1((size_t) width * 4);
+        size_t rowBytes = (size_t) width * components;
+        for (int y = 0; y < outHeight && levelCount > 1; y++)
+        {
+            DecodeRow(image.pixels.get() + std::min(2 * y, height - 1) * rowBytes, width, components, srgbChannels, row0.data());
+            DecodeRow(image.pixels.get() + std::min(2 * y + 1, height - 1) * rowBytes, width, components, srgbChannels, row1.data());
+            DownsampleRows(row0.data(), row1.data(), width, outWidth, &current[(size_t) y * outWidth * 4]);
+        }
+
+        unsigned char *out = storage->data();
+        std::vector<float> next;
+        for (int level = 1; level < levelCount; level++)
+        {
+            width = outWidth;
+            height = outHeight;
+            size_t bytes = (size_t) width * height * components;
+            EncodeTexels(current.data(), (size_t) width * height, components, srgbChannels, out);
+            image.levels.push_back(ImageLevel{width, height, out, bytes});
+            out += bytes;
+            if (level + 1 == levelCount)
+                break;
+            outWidth = std::max(1, width / 2);
+            outHeight = std::max(1, height / 2);
+            next.resize((size_t) outWidth * outHeight * 4);
+            for (int y = 0; y < outHeight; y++)
+                DownsampleRows(&current[(size_t) std::min(2 * y, height - 1) * width * 4],
+                               &current[(size_t) std::min(2 * y + 1, height - 1) * width * 4], width, outWidth,
+                               &next[(size_t) y * outWidth * 4]);
+            current.swap(next);
+        }
+        image.storage = storage;
+        timer.Bytes(chainBytes);
+    }
+}
+#endif
@@ -0,0 +1,267 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_handle.h>
+#include <learnopengl/load_profiler.h>
+#include <learnopengl/texture.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+// Streams decoded images into GL textures a few megabytes per frame instead of blocking the GL thread on glTexImage2D and
+// glGenerateMipmap for the whole image at once.
+//
+// Begin() returns a texture name immediately. Its storage is allocated but not yet sampled: a 1x1 level sits in the last
+// mip level and BASE_LEVEL/MAX_LEVEL point at it. Update(), called once per frame, copies bands of rows into a persistent
+// ring of pixel buffer objects and issues glTexSubImage2D from them, so the transfer itself is asynchronous. A fence
+// recycles each PBO once the GPU has consumed it.
+//
+// Images carrying a mip chain built on a loader thread (see TextureMipmap) are streamed smallest level first, the last
+// level being the real 1x1 texel, and BASE_LEVEL moves down as each level completes, so the texture sharpens while it
+// streams and the GL thread never generates mips. Other images stream level 0 under a grey placeholder; when its last band
+// is in, the mips are generated and the base level switched to 0.
+class TextureStreamer
+{
+public:
+    explicit TextureStreamer(size_t frameBudgetBytes = 8 * 1024 * 1024, size_t slotBytes = 4 * 1024 * 1024, unsigned int slotCount = 4)
+            : frameBudget(frameBudgetBytes), slotSize(slotBytes)
+    {
+        slots.resize(slotCount);
+        for (Slot &slot : slots)
+        {
+            slot.pbo = CreateBuffer();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo.get());
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, slotSize, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    // deletes the PBO ring; call while the GL context is still current
+    void Destroy()
+    {
+        for (Slot &slot : slots)
+        {
+            if (slot.fence)
+                glDeleteSync(slot.fence);
+        }
+        slots.clear();
+        pending.clear();
+    }
+
+    TextureStreamer(const TextureStreamer &) = delete;
+    TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+    // allocates a texture showing the placeholder or smallest level and queues image for streaming; image.pixels and its
+    // levels are kept alive until done
+    unsigned int Begin(const ImageData &image)
+    {
+        GLenum format = FormatFor(image.nrComponents);
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+
+        int lastLevel = MipLevelCount(image.width, image.height) - 1;
+        bool hasMips = (int) image.levels.size() == lastLevel + 1;
+        if (hasMips)
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (int level = 0; level <= lastLevel; level++)
+                glTexImage2D(GL_TEXTURE_2D, level, format, image.levels[level].width, image.levels[level].height, 0, format,
+                             GL_UNSIGNED_BYTE, level == lastLevel ? image.levels[level].data : nullptr);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+        else
+        {
+            static const unsigned char placeholder[4] = {128, 128, 128, 255};
+            glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+            glTexImage2D(GL_TEXTURE_2D, lastLevel, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, lastLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lastLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        Job job;
+        job.textureID = textureID;
+        job.image = image;
+        job.format = format;
+        job.hasMips = hasMips;
+        startLevel(job, hasMips ? lastLevel - 1 : 0);
+        if (job.level < 0)
+            finish(job);
+        else
+            pending.push_back(job);
+        return textureID;
+    }
+
+    // drops a queued image whose texture is being deleted
+    void Cancel(unsigned int textureID)
+    {
+        pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                     [textureID](const Job &job) { return job.textureID == textureID; }), pending.end());
+    }
+
+    // GL thread, once per frame: streams up to the frame budget and finalizes textures whose last band was issued
+    void Update()
+    {
+        size_t budget = frameBudget;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        while (!pending.empty() && budget > 0)
+        {
+            Job &job = pending.front();
+            Slot *slot = freeSlot();
+            if (!slot)
+                break;
+
+            // at least one row per band, even if a single row exceeds the remaining budget
+            size_t bandBytes = std::min(std::min(slotSize, budget), job.rowBytes * (job.height - job.nextRow));
+            int rows = std::max(1, (int) (bandBytes / job.rowBytes));
+            if ((size_t) rows * job.rowBytes > slotSize)
+            {
+                // a row wider than a slot cannot be staged; upload it directly
+                uploadDirect(job);
+                continue;
+            }
+            bandBytes = rows * job.rowBytes;
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->pbo.get());
+            void *staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bandBytes,
+                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (staging)
+            {
+                LoadProfiler::Scope timer(job.image.canonicalPath, LoadProfiler::Upload, bandBytes, true);
+                memcpy(staging, job.data + job.nextRow * job.rowBytes, bandBytes);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                glBindTexture(GL_TEXTURE_2D, job.textureID);
+                glTexSubImage2D(GL_TEXTURE_2D, job.level, 0, job.nextRow, job.width, rows, job.format, GL_UNSIGNED_BYTE, nullptr);
+                slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            if (!staging)
+            {
+                uploadDirect(job);
+                continue;
+            }
+
+            job.nextRow += rows;
+            budget -= std::min(budget, bandBytes);
+            streamedBytes += bandBytes;
+            if (job.nextRow >= job.height)
+                levelDone(job);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    bool Idle() const { return pending.empty(); }
+    size_t PendingCount() const { return pending.size(); }
+    size_t StreamedBytes() const { return streamedBytes; }
+
+    static int MipLevelCount(int width, int height)
+    {
+        int levels = 1;
+        while (std::max(width, height) >> levels)
+            levels++;
+        return levels;
+    }
+
+private:
+    struct Slot {
+        BufferHandle pbo;
+        GLsync fence = nullptr;
+    };
+
+    struct Job {
+        unsigned int textureID;
+        ImageData image;
+        GLenum format;
+        bool hasMips;
+        int level;                  // being streamed; -1 once all are in
+        const unsigned char *data;  // of that level
+        int width, height;
+        size_t rowBytes;
+        int nextRow = 0;
+    };
+
+    // a slot whose previous upload the GPU has finished reading, or nullptr if all are still in flight
+    Slot *freeSlot()
+    {
+        for (unsigned int i = 0; i < slots.size(); i++)
+        {
+            Slot &slot = slots[(nextSlot + i) % slots.size()];
+            if (slot.fence)
+            {
+                GLenum status = glClientWaitSync(slot.fence, 0, 0);
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                    continue;
+                glDeleteSync(slot.fence);
+                slot.fence = nullptr;
+            }
+            nextSlot = (nextSlot + i + 1) % slots.size();
+            return &slot;
+        }
+        return nullptr;
+    }
+
+    void uploadDirect(Job &job)
+    {
+        LoadProfiler::Scope timer(job.image.canonicalPath, LoadProfiler::Upload, job.rowBytes * (job.height - job.nextRow), true);
+        glBindTexture(GL_TEXTURE_2D, job.textureID);
+        glTexSubImage2D(GL_TEXTURE_2D, job.level, 0, job.nextRow, job.width, job.height - job.nextRow, job.format,
+                        GL_UNSIGNED_BYTE, job.data + job.nextRow * job.rowBytes);
+        job.nextRow = job.height;
+        levelDone(job);
+    }
+
+    static void startLevel(Job &job, int level)
+    {
+        job.level = level;
+        job.nextRow = 0;
+        if (level < 0)
+            return;
+        job.width = job.hasMips ? job.image.levels[level].width : job.image.width;
+        job.height = job.hasMips ? job.image.levels[level].height : job.image.height;
+        job.data = job.hasMips ? job.image.levels[level].data : job.image.pixels.get();
+        job.rowBytes = (size_t) job.width * job.image.nrComponents;
+    }
+
+    // shows the level just streamed, together with the smaller ones already in, and moves on to the next larger one;
+    // pending.front() is the job
+    void levelDone(Job &job)
+    {
+        if (job.hasMips && job.level > 0)
+        {
+            glBindTexture(GL_TEXTURE_2D, job.textureID);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job.level);
+            startLevel(job, job.level - 1);
+            return;
+        }
+        finish(job);
+        pending.pop_front();
+    }
+
+    // makes level 0 and the full chain visible, generating the mips if the image came without them
+    static void finish(Job &job)
+    {
+        glBindTexture(GL_TEXTURE_2D, job.textureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        if (job.hasMips)
+            return;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+        LoadProfiler::Scope timer(job.image.canonicalPath, LoadProfiler::Mipmap, job.image.GpuBytes() - job.image.DataBytes(), true);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    size_t frameBudget;
+    size_t slotSize;
+    std::vector<Slot> slots;
+    unsigned int nextSlot = 0;
+    std::deque<Job> pending;
+    size_t streamedBytes = 0;
+};
+#endif
@@ -0,0 +1,140 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads executing submitted tasks in FIFO order.
+// Tasks must not touch OpenGL; hand GL work back to the render thread through an UploadQueue.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        for (unsigned int i = 0; i < threadCount; i++)
+            workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // process-wide pool for fanning work out inside a single load (see ParallelFor)
+    static ThreadPool &Instance()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    void Submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        wakeup.notify_one();
+    }
+
+    unsigned int ThreadCount() const { return (unsigned int) workers.size(); }
+
+    // runs task(0) ... task(count - 1) and returns once all have finished. The calling thread takes indices too and only
+    // waits for ones a worker already started, so this may be called from a task, including one of this pool's.
+    void ParallelFor(size_t count, const std::function<void(size_t)> &task)
+    {
+        if (count == 0)
+            return;
+        struct Batch {
+            const std::function<void(size_t)> *task;
+            size_t count;
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> done{0};
+            std::mutex mutex;
+            std::condition_variable finished;
+
+            // false once every index is taken; task is only touched while some index is still outstanding
+            bool runOne()
+            {
+                size_t index = next++;
+                if (index >= count)
+                    return false;
+                (*task)(index);
+                if (++done == count)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished.notify_all();
+                }
+                return true;
+            }
+        };
+        std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+        batch->task = &task;
+        batch->count = count;
+        size_t helpers = std::min<size_t>(count - 1, workers.size());
+        for (size_t i = 0; i < helpers; i++)
+            Submit([batch]() {
+                while (batch->runOne())
+                    ;
+            });
+        while (batch->runOne())
+            ;
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->finished.wait(lock, [&batch]() { return batch->done == batch->count; });
+    }
+
+    // blocks until every submitted task has finished; must not be called from a task
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return tasks.empty() && running == 0; });
+    }
+
+private:
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeup.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                running++;
+            }
+            task();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running--;
+            }
+            idle.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable idle;
+    unsigned int running = 0;
+    bool stopping = false;
+};
+#endif
@@ -0,0 +1,146 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/gl_handle.h>
+
+#include <cstring>
+
+// Binding points of the uniform blocks shared by every program. A program declaring a block of one of these names has it
+// bound when it is linked (see Shader), so shaders added later pick the shared data up without any setup.
+namespace UniformBlocks {
+    enum Binding : GLuint {
+        Frame = 0,      // FrameUniforms
+        Lights = 1,     // LightUniforms
+        BindingCount
+    };
+
+    inline const char *Name(Binding binding)
+    {
+        static const char *names[BindingCount] = {"Frame", "Lights"};
+        return names[binding];
+    }
+}
+
+// std140 mirrors of the shared blocks. std140 aligns a vec3 like a vec4 but lets a scalar fill the fourth component, so
+// each vec3 is followed by a float, used or padding, and the structs match the GLSL declarations byte for byte:
+//
+//     layout (std140) uniform Frame {
+//         mat4 projection;
+//         mat4 view;
+//         vec3 viewPosition;
+//     };
+struct FrameUniforms {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 viewPosition;
+    float padding0;
+};
+
+//     struct PointLight {
+//         vec3 position;  float constant;
+//         vec3 ambient;   float linear;
+//         vec3 diffuse;   float quadratic;
+//         vec3 specular;
+//         vec3 color;
+//     };
+//     struct DirLight {
+//         vec3 direction;
+//         vec3 ambient;
+//         vec3 diffuse;
+//         vec3 specular;
+//     };
+//     layout (std140) uniform Lights {
+//         PointLight pointLight[NR_OF_POINT_LIGHTS];
+//         DirLight dirLight;
+//         vec3 lightColor;
+//     };
+struct LightUniforms {
+    static const int PointLightCount = 4;   // NR_OF_POINT_LIGHTS
+
+    struct PointLight {
+        glm::vec3 position;
+        float constant;
+        glm::vec3 ambient;
+        float linear;
+        glm::vec3 diffuse;
+        float quadratic;
+        glm::vec3 specular;
+        float padding0;
+        glm::vec3 color;
+        float padding1;
+    };
+
+    struct DirLight {
+        glm::vec3 direction;
+        float padding0;
+        glm::vec3 ambient;
+        float padding1;
+        glm::vec3 diffuse;
+        float padding2;
+        glm::vec3 specular;
+        float padding3;
+    };
+
+    PointLight pointLight[PointLightCount];
+    DirLight dirLight;
+    glm::vec3 lightColor;
+    float padding0;
+};
+
+static_assert(sizeof(FrameUniforms) == 144, "FrameUniforms must match the std140 layout of Frame");
+static_assert(sizeof(LightUniforms::PointLight) == 80, "PointLight must match its std140 array stride");
+static_assert(sizeof(LightUniforms) == 4 * 80 + 64 + 16, "LightUniforms must match the std140 layout of Lights");
+
+// A uniform buffer holding one T, bound to its block's binding point for as long as it exists. Callers fill the block
+// every frame and Update() sends it only if it differs from what the buffer holds, so values that stay put cost a memcmp
+// rather than an upload per program and uniform.
+//
+//     UniformBuffer<FrameUniforms> frame(UniformBlocks::Frame);
+//     ...
+//     frame.Data().view = camera.GetViewMatrix();
+//     frame.Update();     // before the first draw that reads it
+template<class T>
+class UniformBuffer
+{
+public:
+    explicit UniformBuffer(UniformBlocks::Binding binding) : buffer(CreateBuffer())
+    {
+        memset((void *) &data, 0, sizeof(T));
+        memset((void *) &uploaded, 0, sizeof(T));
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer.get());
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), &uploaded, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer.get());
+    }
+
+    UniformBuffer(const UniformBuffer &) = delete;
+    UniformBuffer &operator=(const UniformBuffer &) = delete;
+
+    // the CPU copy, sent by the next Update(); padding members are left alone so they never make the block look changed
+    T &Data() { return data; }
+
+    // uploads the block if it changed since the last upload; returns whether it did
+    bool Update()
+    {
+        if (memcmp(&data, &uploaded, sizeof(T)) == 0)
+            return false;
+        uploaded = data;
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer.get());
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &uploaded);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        uploads++;
+        return true;
+    }
+
+    size_t Uploads() const { return uploads; }
+
+private:
+    BufferHandle buffer;
+    T data;
+    T uploaded;
+    size_t uploads = 0;
+};
+#endif
@@ -0,0 +1,86 @@
+#ifndef UPLOAD_QUEUE_H
+#define UPLOAD_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+// Lock-free multi-producer/single-consumer queue of GL jobs. Worker threads Push() closures that must run on the thread
+// owning the GL context; that thread calls Drain() once per iteration to run everything pushed so far, in push order.
+class UploadQueue
+{
+public:
+    UploadQueue() : head(nullptr) {}
+
+    ~UploadQueue()
+    {
+        for (Node *node : {head.exchange(nullptr), backlog})
+        {
+            while (node)
+            {
+                Node *next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+    }
+
+    UploadQueue(const UploadQueue &) = delete;
+    UploadQueue &operator=(const UploadQueue &) = delete;
+
+    // safe to call from any thread
+    void Push(std::function<void()> job)
+    {
+        Node *node = new Node{std::move(job), head.load(std::memory_order_relaxed)};
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+
+    // GL thread only; returns the number of jobs executed
+    unsigned int Drain()
+    {
+        return DrainUntil(std::chrono::steady_clock::time_point::max());
+    }
+
+    // GL thread only: like Drain(), but starts no job once deadline has passed (at least one runs, so the queue always
+    // makes progress). The rest stays queued ahead of later pushes for the next call.
+    unsigned int DrainUntil(std::chrono::steady_clock::time_point deadline)
+    {
+        // detach the whole stack at once (no ABA: the consumer never pops single nodes), then reverse it into push order
+        // behind what an earlier call left over
+        Node *node = head.exchange(nullptr, std::memory_order_acquire);
+        Node *ordered = nullptr;
+        while (node)
+        {
+            Node *next = node->next;
+            node->next = ordered;
+            ordered = node;
+            node = next;
+        }
+        Node **tail = &backlog;
+        while (*tail)
+            tail = &(*tail)->next;
+        *tail = ordered;
+
+        unsigned int executed = 0;
+        while (backlog && (executed == 0 || std::chrono::steady_clock::now() < deadline))
+        {
+            Node *job = backlog;
+            backlog = job->next;
+            job->job();
+            delete job;
+            executed++;
+        }
+        return executed;
+    }
+
+private:
+    struct Node {
+        std::function<void()> job;
+        Node *next;
+    };
+
+    std::atomic<Node *> head;
+    Node *backlog = nullptr;    // consumer side: detached jobs in push order, left over by DrainUntil()
+};
+#endif
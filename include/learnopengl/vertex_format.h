@@ -0,0 +1,273 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/virtual_file_system.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// canonical, full precision vertex produced by the importers and stored in the mesh cache
+struct Vertex {
+    // position
+    glm::vec3 Position;
+    // normal
+    glm::vec3 Normal;
+    // texCoords
+    glm::vec2 TexCoords;
+    // tangent
+    glm::vec3 Tangent;
+    // bitangent
+    glm::vec3 Bitangent;
+};
+
+// Attribute streams a vertex shader consumes. Meshes are packed for one layout at import time, so attributes the shader
+// never reads are neither uploaded nor fetched. Attribute locations stay those of the canonical Vertex:
+//   0 position   - 3 x unorm16 relative to the mesh AABB (+ 2 bytes padding); the shader rebuilds it with
+//                  positionOffset + aPos * positionScale
+//   1 normal     - octahedral, 2 x snorm16
+//   2 texCoords  - 2 x half float, or 2 x float when a mesh tiles its UVs beyond the range half keeps texel accuracy for
+//   3 tangent    - octahedral tangent in xy and the bitangent handedness in z, 4 x snorm16; the bitangent is rebuilt as
+//                  cross(normal, tangent) * z. A shader declaring location 3 or 4 gets this stream.
+struct VertexLayout {
+    bool normals = true;
+    bool texCoords = true;
+    bool tangentFrame = false;
+
+    // layout matching the inputs declared with "layout (location = N) in" by the vertex shader at path
+    static VertexLayout FromShader(const std::string &vertexShaderPath)
+    {
+        VertexLayout layout;
+        FileView file = VirtualFileSystem::Instance().Open(vertexShaderPath);
+        if (!file)
+            return layout;
+        std::istringstream source(file.String());
+        bool used[5] = {false, false, false, false, false};
+        std::string line;
+        while (std::getline(source, line))
+        {
+            size_t location = line.find("location");
+            size_t equals = line.find('=', location);
+            if (location == std::string::npos || equals == std::string::npos || line.find(" in ") == std::string::npos)
+                continue;
+            int index = atoi(line.c_str() + equals + 1);
+            if (index >= 0 && index < 5)
+                used[index] = true;
+        }
+
+        layout.normals = used[1];
+        layout.texCoords = used[2];
+        layout.tangentFrame = used[3] || used[4];
+        return layout;
+    }
+};
+
+// UVs within this magnitude keep at least 1/1024 precision as half floats
+static const float HalfTexCoordLimit = 2.0f;
+
+inline uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int) ((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+    if (((bits >> 23) & 0xff) == 0xff)
+        return (uint16_t) (sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    if (exponent >= 31)
+        return (uint16_t) (sign | 0x7bff);
+    if (exponent <= 0)
+    {
+        // subnormal half, rounded to nearest even
+        if (exponent < -10)
+            return (uint16_t) sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (rest > midpoint || (rest == midpoint && (half & 1)))
+            half++;
+        return (uint16_t) (sign | half);
+    }
+    uint32_t half = ((uint32_t) exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;
+    if (half >= 0x7c00)
+        half = 0x7bff;
+    return (uint16_t) (sign | half);
+}
+
+inline int16_t ToSnorm16(float value)
+{
+    return (int16_t) std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+// maps a unit vector onto the octahedron unfolded into [-1, 1]^2
+inline glm::vec2 OctahedralEncode(glm::vec3 n)
+{
+    float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (sum == 0.0f)
+        return glm::vec2(0.0f);
+    n /= sum;
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        e.x = (1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        e.y = (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return e;
+}
+
+// GPU-ready vertex and index streams of one mesh in a VertexLayout
+struct PackedGeometry {
+    VertexLayout layout;
+    bool fullTexCoords = false;
+    size_t stride = 0;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    std::vector<unsigned char> vertices;
+    std::vector<unsigned char> indices;
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(0.0f);
+
+    bool Empty() const { return vertices.empty(); }
+
+    // geometry with equal keys has identical attribute formats and can share one vertex buffer
+    unsigned int FormatKey() const
+    {
+        return (layout.normals ? 1u : 0u) | (layout.texCoords ? 2u : 0u) | (layout.tangentFrame ? 4u : 0u) | (fullTexCoords ? 8u : 0u);
+    }
+
+    // quantizes vertices against their bounds and narrows indices to 16 bits when every index fits
+    static PackedGeometry Pack(const Vertex *vertexData, size_t vertexCount, const unsigned int *indexData, size_t indexCount,
+                               const VertexLayout &layout, glm::vec3 boundsMin, glm::vec3 boundsMax)
+    {
+        PackedGeometry packed;
+        packed.layout = layout;
+        packed.vertexCount = vertexCount;
+        packed.indexCount = indexCount;
+        packed.positionOffset = boundsMin;
+        packed.positionScale = boundsMax - boundsMin;
+        for (size_t i = 0; layout.texCoords && i < vertexCount; i++)
+        {
+            if (std::fabs(vertexData[i].TexCoords.x) > HalfTexCoordLimit || std::fabs(vertexData[i].TexCoords.y) > HalfTexCoordLimit)
+            {
+                packed.fullTexCoords = true;
+                break;
+            }
+        }
+        packed.stride = packed.computeStride();
+
+        packed.vertices.resize(vertexCount * packed.stride);
+        glm::vec3 invScale;
+        for (int axis = 0; axis < 3; axis++)
+            invScale[axis] = packed.positionScale[axis] > 0.0f ? 65535.0f / packed.positionScale[axis] : 0.0f;
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            const Vertex &vertex = vertexData[i];
+            unsigned char *out = &packed.vertices[i * packed.stride];
+
+            uint16_t position[4] = {0, 0, 0, 0};
+            for (int axis = 0; axis < 3; axis++)
+                position[axis] = (uint16_t) std::min(std::max(std::lround((vertex.Position[axis] - boundsMin[axis]) * invScale[axis]), 0L), 65535L);
+            out = put(out, position, sizeof(position));
+
+            if (layout.normals)
+            {
+                glm::vec2 e = OctahedralEncode(vertex.Normal);
+                int16_t normal[2] = {ToSnorm16(e.x), ToSnorm16(e.y)};
+                out = put(out, normal, sizeof(normal));
+            }
+            if (layout.texCoords && packed.fullTexCoords)
+                out = put(out, &vertex.TexCoords, sizeof(glm::vec2));
+            else if (layout.texCoords)
+            {
+                uint16_t uv[2] = {FloatToHalf(vertex.TexCoords.x), FloatToHalf(vertex.TexCoords.y)};
+                out = put(out, uv, sizeof(uv));
+            }
+            if (layout.tangentFrame)
+            {
+                glm::vec2 e = OctahedralEncode(vertex.Tangent);
+                float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+                int16_t tangent[4] = {ToSnorm16(e.x), ToSnorm16(e.y), ToSnorm16(handedness), 0};
+                put(out, tangent, sizeof(tangent));
+            }
+        }
+
+        if (vertexCount <= 65536)
+        {
+            packed.indexType = GL_UNSIGNED_SHORT;
+            packed.indices.resize(indexCount * sizeof(uint16_t));
+            uint16_t *narrow = reinterpret_cast<uint16_t *>(packed.indices.data());
+            for (size_t i = 0; i < indexCount; i++)
+                narrow[i] = (uint16_t) indexData[i];
+        }
+        else
+        {
+            packed.indexType = GL_UNSIGNED_INT;
+            packed.indices.resize(indexCount * sizeof(unsigned int));
+            memcpy(packed.indices.data(), indexData, packed.indices.size());
+        }
+        return packed;
+    }
+
+    // points the attributes of the bound VAO at the bound GL_ARRAY_BUFFER
+    void SetupAttributes() const
+    {
+        size_t offset = 0;
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, (GLsizei) stride, (void *) offset);
+        offset += 4 * sizeof(uint16_t);
+        if (layout.normals)
+        {
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, (GLsizei) stride, (void *) offset);
+            offset += 2 * sizeof(int16_t);
+        }
+        if (layout.texCoords)
+        {
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, fullTexCoords ? GL_FLOAT : GL_HALF_FLOAT, GL_FALSE, (GLsizei) stride, (void *) offset);
+            offset += fullTexCoords ? 2 * sizeof(float) : 2 * sizeof(uint16_t);
+        }
+        if (layout.tangentFrame)
+        {
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 4, GL_SHORT, GL_TRUE, (GLsizei) stride, (void *) offset);
+        }
+    }
+
+    size_t IndexSize() const { return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int); }
+
+private:
+    size_t computeStride() const
+    {
+        size_t size = 4 * sizeof(uint16_t);
+        if (layout.normals)
+            size += 2 * sizeof(int16_t);
+        if (layout.texCoords)
+            size += fullTexCoords ? 2 * sizeof(float) : 2 * sizeof(uint16_t);
+        if (layout.tangentFrame)
+            size += 4 * sizeof(int16_t);
+        return size;
+    }
+
+    static unsigned char *put(unsigned char *out, const void *data, size_t size)
+    {
+        memcpy(out, data, size);
+        return out + size;
+    }
+};
+#endif
@@ -0,0 +1,67 @@
+#ifndef VFS_IO_SYSTEM_H
+#define VFS_IO_SYSTEM_H
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include <learnopengl/virtual_file_system.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+// read-only ASSIMP stream over a FileView
+class VfsIOStream : public Assimp::IOStream
+{
+public:
+    explicit VfsIOStream(FileView view) : view(std::move(view)) {}
+
+    size_t Read(void *buffer, size_t size, size_t count) override
+    {
+        if (size == 0)
+            return 0;
+        count = std::min(count, (view.size - position) / size);
+        memcpy(buffer, view.data + position, size * count);
+        position += size * count;
+        return count;
+    }
+
+    size_t Write(const void *buffer, size_t size, size_t count) override { return 0; }
+
+    aiReturn Seek(size_t offset, aiOrigin origin) override
+    {
+        size_t target = origin == aiOrigin_SET ? offset : origin == aiOrigin_CUR ? position + offset : view.size + offset;
+        if (target > view.size)
+            return aiReturn_FAILURE;
+        position = target;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override { return position; }
+    size_t FileSize() const override { return view.size; }
+    void Flush() override {}
+
+private:
+    FileView view;
+    size_t position = 0;
+};
+
+// Routes every file ASSIMP opens, including the .bin and .mtl files a model references, through the VirtualFileSystem.
+// The importer takes ownership: importer.SetIOHandler(new VfsIOSystem()).
+class VfsIOSystem : public Assimp::IOSystem
+{
+public:
+    bool Exists(const char *path) const override { return VirtualFileSystem::Instance().Exists(path); }
+    char getOsSeparator() const override { return '/'; }
+
+    Assimp::IOStream *Open(const char *path, const char *mode = "rb") override
+    {
+        if (strchr(mode, 'w') || strchr(mode, 'a'))
+            return nullptr;
+        FileView view = VirtualFileSystem::Instance().Open(path);
+        return view ? new VfsIOStream(std::move(view)) : nullptr;
+    }
+
+    void Close(Assimp::IOStream *stream) override { delete stream; }
+};
+#endif
@@ -0,0 +1,149 @@
+#ifndef VIRTUAL_FILE_SYSTEM_H
+#define VIRTUAL_FILE_SYSTEM_H
+
+#include <learnopengl/load_profiler.h>
+#include <learnopengl/lz4.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/resource_pack.h>
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// read-only contents of a file: either a view into the mounted pack, or bytes kept alive by storage (a decompressed
+// pack entry or the mapping of a loose file)
+struct FileView {
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> storage;
+
+    explicit operator bool() const { return data != nullptr; }
+    std::string String() const { return data ? std::string(reinterpret_cast<const char *>(data), size) : std::string(); }
+};
+
+// Process-wide file access for every asset reader. Paths are looked up in the mounted ResourcePack first and fall back to
+// loose files on disk, so running without a pack only costs speed; rebuild it with hk_pack after editing resources. A
+// pack mounted from <dir>/resources.hkpack serves paths relative to <dir>, or below it as FileSystem::getPath builds them.
+//
+// Mount() and Unmount() must not run while loader threads read files; Open() and Exists() are thread-safe.
+class VirtualFileSystem
+{
+public:
+    static VirtualFileSystem &Instance()
+    {
+        static VirtualFileSystem instance;
+        return instance;
+    }
+
+    bool Mount(const std::string &packPath)
+    {
+        if (!pack.Open(packPath))
+            return false;
+        size_t slash = packPath.find_last_of('/');
+        root = slash == std::string::npos ? "" : packPath.substr(0, slash);
+        return true;
+    }
+
+    void Unmount()
+    {
+        pack.Close();
+        root.clear();
+    }
+
+    bool Mounted() const { return pack.IsOpen(); }
+
+    bool Exists(const std::string &path) const
+    {
+        struct stat st;
+        return pack.Find(packPath(path)) != nullptr || stat(path.c_str(), &st) == 0;
+    }
+
+    // contents of path, or an empty view if it is neither in the pack nor on disk
+    FileView Open(const std::string &path) const
+    {
+        FileView view;
+        if (const ResourcePack::Entry *entry = pack.Find(packPath(path)))
+        {
+            packReads++;
+            auto start = std::chrono::steady_clock::now();
+            size_t resident = LoadProfiler::Instance().Enabled() ? MappedFile::ResidentBytes(pack.Data(*entry), entry->size) : 0;
+            if (!pack.Compressed(*entry))
+            {
+                view.data = pack.Data(*entry);
+                view.size = entry->rawSize;
+                profile(path, start, entry->size, resident);
+                return view;
+            }
+            std::shared_ptr<std::vector<unsigned char>> bytes = std::make_shared<std::vector<unsigned char>>(entry->rawSize);
+            if (!LZ4::Decompress(pack.Data(*entry), entry->size, bytes->data(), bytes->size()))
+            {
+                std::cout << "ERROR::VFS:: corrupt pack entry " << path << std::endl;
+                return FileView();
+            }
+            view.data = bytes->data();
+            view.size = bytes->size();
+            view.storage = bytes;
+            profile(path, start, entry->size, resident);
+            return view;
+        }
+
+        return OpenLoose(path);
+    }
+
+    // contents of the file on disk, bypassing the pack; for caches the game rewrites while a pack holds an older copy
+    FileView OpenLoose(const std::string &path) const
+    {
+        FileView view;
+        auto start = std::chrono::steady_clock::now();
+        std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+        if (!file->IsOpen())
+            return view;
+        looseReads++;
+        view.data = file->data;
+        view.size = file->size;
+        view.storage = file;
+        if (LoadProfiler::Instance().Enabled())
+            profile(path, start, file->size, MappedFile::ResidentBytes(file->data, file->size));
+        return view;
+    }
+
+    bool Packed(const std::string &path) const { return pack.Find(packPath(path)) != nullptr; }
+
+    void PrintStats(std::ostream &out = std::cout) const
+    {
+        out << "VFS:: " << (pack.IsOpen() ? pack.EntryCount() : 0) << " packed files, " << packReads << " reads from the pack, "
+            << looseReads << " from loose files" << std::endl;
+    }
+
+private:
+    VirtualFileSystem() {}
+
+    // records a read with the LoadProfiler; mapped files are paged in as they are parsed, so that time shows up there
+    static void profile(const std::string &path, std::chrono::steady_clock::time_point start, size_t bytes, size_t resident)
+    {
+        LoadProfiler::Instance().AddFile(path, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                                         bytes, resident);
+    }
+
+    // key of path inside the pack: relative to the pack's directory, without leading "./"
+    std::string packPath(const std::string &path) const
+    {
+        size_t start = 0;
+        if (!root.empty() && path.size() > root.size() && path.compare(0, root.size(), root) == 0 && path[root.size()] == '/')
+            start = root.size() + 1;
+        while (path.compare(start, 2, "./") == 0)
+            start += 2;
+        return path.substr(start);
+    }
+
+    ResourcePack pack;
+    std::string root;
+    mutable std::atomic<size_t> packReads{0};
+    mutable std::atomic<size_t> looseReads{0};
+};
+#endif
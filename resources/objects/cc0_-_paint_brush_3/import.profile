@@ -0,0 +1,2 @@
+# a few thousand triangles at most: import fast, reordering gains nothing measurable
+optimize = false
@@ -0,0 +1,2 @@
+# OBJ export placed by its own origin; the scene positions were authored against it
+recenter = false
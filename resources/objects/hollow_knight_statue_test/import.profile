@@ -0,0 +1,3 @@
+# dense sculpted mesh: merge what can be merged, keep the full optimization pass
+mergeMeshes = true
+dedupMaterials = true
@@ -0,0 +1,12 @@
+# Import profile for every model below this directory. A model directory's import.profile, and then a
+# <model file>.profile next to the model, override individual keys; see include/learnopengl/import_profile.h.
+#
+# Static node transforms are always baked into the vertices; pretransform stays off so animated nodes keep their hierarchy.
+weld = true
+optimize = true
+normals = smooth
+# 2.model_lighting.vs reads no tangent frame
+tangents = false
+flipUVs = true
+# exporters leave models far from their origin; scenes place them by the bottom center of their bounds instead
+recenter = true
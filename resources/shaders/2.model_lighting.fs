@@ -2,16 +2,16 @@
 layout (location = 0) out vec4 FragColor;
 layout (location = 1) out vec4 BrightColor;
 
+// std140, mirrored by LightUniforms
 struct PointLight {
     vec3 position;
-
-    vec3 specular;
-    vec3 diffuse;
-    vec3 ambient;
-
     float constant;
+    vec3 ambient;
     float linear;
+    vec3 diffuse;
     float quadratic;
+    vec3 specular;
+    vec3 color;
 };
 
 struct DirLight {
@@ -33,14 +33,20 @@ in vec3 FragPos;
 
 #define NR_OF_POINT_LIGHTS 4
 
-uniform PointLight pointLight[NR_OF_POINT_LIGHTS];
-uniform DirLight dirLight;
-uniform Material material;
-uniform vec3 lightColor;
-uniform vec3 color[NR_OF_POINT_LIGHTS];
+layout (std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPosition;
+};
 
+layout (std140) uniform Lights {
+    PointLight pointLight[NR_OF_POINT_LIGHTS];
+    DirLight dirLight;
+    vec3 lightColor;
+};
+
+uniform Material material;
 
-uniform vec3 viewPosition;
 // calculates the color when using a point light.
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
@@ -90,7 +96,7 @@ void main()
     vec3 result1 = vec3(0.0f);
     vec3 result = CalcDirLight(dirLight, normal, viewDir);
     for(int i = 0; i < NR_OF_POINT_LIGHTS; i++){
-        result1 += CalcPointLight(pointLight[i], normal, FragPos, viewDir) * color[i];
+        result1 += CalcPointLight(pointLight[i], normal, FragPos, viewDir) * pointLight[i].color;
     }
 
     FragColor = vec4((result*lightColor)+result1, 1.0);
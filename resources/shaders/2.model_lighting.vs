@@ -1,20 +1,51 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+layout (location = 1) in vec2 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 out vec3 Normal;
 out vec3 FragPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// model and normal matrices of every object, TEXELS_PER_OBJECT texels each (defined by ObjectTransforms::ShaderDefines)
+uniform samplerBuffer objectTransforms;
+uniform int objectIndex;
+// world matrix of the animated model node the mesh hangs from, identity for meshes baked into model space (see
+// NodeHierarchy), and its normal matrix
+uniform mat4 nodeTransform = mat4(1.0);
+uniform mat3 nodeNormalMatrix = mat3(1.0);
+
+layout (std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPosition;
+};
+
+// positions arrive as 16-bit offsets inside the mesh bounds
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+// inverse of the octahedral normal encoding used by the mesh packer
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    int base = objectIndex * TEXELS_PER_OBJECT;
+    mat4 model = mat4(texelFetch(objectTransforms, base), texelFetch(objectTransforms, base + 1),
+                      texelFetch(objectTransforms, base + 2), texelFetch(objectTransforms, base + 3)) * nodeTransform;
+    mat3 normalMatrix = mat3(texelFetch(objectTransforms, base + 4).xyz, texelFetch(objectTransforms, base + 5).xyz,
+                             texelFetch(objectTransforms, base + 6).xyz) * nodeNormalMatrix;
+
+    vec3 position = positionOffset + aPos * positionScale;
+    FragPos = vec3(model * vec4(position, 1.0));
+    Normal = normalMatrix * octahedralDecode(aNormal);
     TexCoords = aTexCoords;    
     gl_Position = projection * view * vec4(FragPos, 1.0);
-}
\ No newline at end of file
+}
@@ -10,10 +10,18 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <learnopengl/filesystem.h>
+#include <learnopengl/load_profiler.h>
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
-
+#include <learnopengl/object_transforms.h>
+#include <learnopengl/asset_loader.h>
+#include <learnopengl/residency_manager.h>
+#include <learnopengl/scene_graph.h>
+#include <learnopengl/texture_cubemap.h>
+#include <learnopengl/texture_streamer.h>
+
+#include <cstdlib>
 #include <iostream>
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
@@ -26,7 +34,7 @@ void processInput(GLFWwindow *window);
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
 
-unsigned int loadCubemap(vector<std::string> faces);
+AssetHandle<TextureHandle> loadCubemap(AssetLoader &loader, vector<std::string> faces);
 
 // settings
 unsigned int SCR_WIDTH = 1600;
@@ -44,6 +52,14 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// uniforms set every frame, hashed at compile time
+constexpr UniformId MaterialShininess("material.shininess");
+constexpr UniformId ObjectIndex("objectIndex");
+constexpr UniformId Horizontal("horizontal");
+constexpr UniformId Hdr("hdr");
+constexpr UniformId Bloom("bloom");
+constexpr UniformId Exposure("exposure");
+
 struct PointLight {
     glm::vec3 position;
     glm::vec3 ambient;
@@ -60,34 +76,9 @@ struct ProgramState {
     bool ImGuiEnabled = false;
     Camera camera;
     bool CameraMouseMovementUpdateEnabled = true;
-    glm::vec3 backpackPosition = glm::vec3(0.0f);
-    glm::vec3 tablePosition = glm::vec3(-1.0f, -3.9f, 3.0f);
-    glm::vec3 hollowknightPosition = glm::vec3(0.0f, 0.3f, 13.0f);
-    glm::vec3 paintbrushPosition = glm::vec3(5.0f, -0.85f, -1.0f);
-    glm::vec3 hornetPosition = glm::vec3(0.0f, -0.15f, 0.0f);
-    glm::vec3 statuePosition = glm::vec3(-9.0f, 4.5f, 7.0f);
-    glm::vec3 gemPosition = glm::vec3(7.0f, 0.0f, 15.6f);
-    glm::vec3 candlePosition = glm::vec3(-9.0f, 0.3f, 22.0f);
-    glm::vec3 booksPosition = glm::vec3(6.0f, 2.75f, -23.0f);
-    glm::vec3 ghostPosition = glm::vec3(-5.0f, 9.5f, -8.0f);
-    glm::vec3 rubikscubePosition = glm::vec3(-9.0f, 0.3f, 31.0f);
-    glm::vec3 bushPosition = glm::vec3(10.0f, 1.3f, 19.0f);
-    glm::vec3 doorPosition = glm::vec3(54.0f, 76.0f, 5.0f);
-    glm::vec3 HKPosition = glm::vec3(-10.0f, -1.2f, -18.0f);
-    glm::vec3 notebookPosition = glm::vec3(8.0f, -0.8f, 32.0f);
-
-    float tableScale = 40.0f;
-    float paintbrushScale = 1.5f;
-    float statueScale = 6.0f;
-    float gemScale = 2.0f;
-    float candleScale = 1.0f;
-    float booksScale = 0.2f;
-    float ghostScale = 11.0f;
-    float rubikscubeScale = 0.5f;
-    float bushScale = 5.0f;
-    float doorScale = 20.0f;
-    float HKScale = 0.5f;
-    float notebookScale = 0.05f;
+    // everything placed in the world, from the scene file
+    SceneGraph scene;
+    int selectedNode = 0;
 
 
     bool hdr = true;
@@ -139,7 +130,24 @@ ProgramState *programState;
 
 void DrawImGui(ProgramState *programState);
 
+void runScene(GLFWwindow *window, TextureStreamer &textureStreamer);
+
+// fills one light of the Lights block from light, with its own diffuse, falloff and colour
+void setPointLight(LightUniforms::PointLight &out, const PointLight &light, const glm::vec3 &diffuse, float linear,
+                   float quadratic, const glm::vec3 &color) {
+    out.position = light.position;
+    out.ambient = light.ambient;
+    out.diffuse = diffuse;
+    out.specular = light.specular;
+    out.constant = light.constant;
+    out.linear = linear;
+    out.quadratic = quadratic;
+    out.color = color;
+}
+
 int main() {
+    // startup is timed per asset and phase until every texture is resident, see the report below
+    LoadProfiler::Instance().Begin();
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -173,6 +181,13 @@ int main() {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // HK_PROFILE_SYNC=1 makes the startup report wait for the driver after every GL phase, at the cost of a slower startup
+    if (getenv("HK_PROFILE_SYNC"))
+        LoadProfiler::Instance().SyncGL([]() { glFinish(); });
+    // cooked textures use S3TC where the driver exposes it
+    TextureCompression::DetectSupport();
+    // assets are read from the pack built by hk_pack when there is one, from the loose files otherwise
+    VirtualFileSystem::Instance().Mount(FileSystem::getPath("resources.hkpack"));
 
 
     programState = new ProgramState;
@@ -191,6 +206,31 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330 core");
 
+    // large textures are streamed in over the first frames and show a placeholder until they are resident
+    TextureStreamer textureStreamer;
+    TextureRegistry::Instance().SetStreamer(&textureStreamer);
+
+    // everything holding GL objects or registry references is local to runScene(), so it is destroyed while the context
+    // is still current and before the registries it refers to are shut down
+    runScene(window, textureStreamer);
+
+    TextureRegistry::Instance().Shutdown();
+    GeometryBuffers::Instance().Shutdown();
+    textureStreamer.Destroy();
+
+    programState->SaveToFile("resources/program_state.txt");
+    delete programState;
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return 0;
+}
+
+// builds the scene and runs the render loop until the window is closed
+void runScene(GLFWwindow *window, TextureStreamer &textureStreamer) {
     // configure global opengl state
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
@@ -205,66 +245,56 @@ int main() {
 
     // build and compile shaders
     // -------------------------
-    Shader ourShader("resources/shaders/2.model_lighting.vs", "resources/shaders/2.model_lighting.fs");
+    Shader ourShader("resources/shaders/2.model_lighting.vs", "resources/shaders/2.model_lighting.fs", nullptr,
+                     ObjectTransforms::ShaderDefines());
     Shader skyboxShader("resources/shaders/skybox.vs", "resources/shaders/skybox.fs");
     Shader hdrBloomShader("resources/shaders/hdrBloom.vs", "resources/shaders/hdrBloom.fs");
     Shader blurShader("resources/shaders/blur.vs", "resources/shaders/blur.fs");
+    // camera and lights, bound to every program declaring their blocks
+    UniformBuffer<FrameUniforms> frameUniforms(UniformBlocks::Frame);
+    UniformBuffer<LightUniforms> lightUniforms(UniformBlocks::Lights);
 
     // load models
     // -----------
-
-
-    Model hornet("resources/objects/hornet_-_hollow_knight/scene.gltf");
-    hornet.SetShaderTextureNamePrefix("material.");
-
-    Model hollowknight("resources/objects/hollowKnight/untitled.obj");
-    hollowknight.SetShaderTextureNamePrefix("material.");
-
-    Model table("resources/objects/antique_wooden_desk/scene.gltf");
-    table.SetShaderTextureNamePrefix("material.");
-
-    Model paintBrush("resources/objects/cc0_-_paint_brush_3/scene.gltf");
-    paintBrush.SetShaderTextureNamePrefix("material.");
-
-    Model statue("resources/objects/hollow_knight_statue_test/scene.gltf");
-    statue.SetShaderTextureNamePrefix("material.");
-
-    Model gem("resources/objects/gem_pack/scene.gltf");
-    gem.SetShaderTextureNamePrefix("material.");
-
-    Model candle("resources/objects/candle/scene.gltf");
-    candle.SetShaderTextureNamePrefix("material.");
-
-    Model books("resources/objects/pile_of_books/scene.gltf");
-    books.SetShaderTextureNamePrefix("material.");
-
-    Model ghost("resources/objects/hollow_knight_grimmchild_animation/scene.gltf");
-    ghost.SetShaderTextureNamePrefix("material.");
-
-    Model rubiksCube("resources/objects/rubiks_cube/scene.gltf");
-    rubiksCube.SetShaderTextureNamePrefix("material.");
-
-    Model bush1("resources/objects/stylized_bush_v1/scene.gltf");
-    bush1.SetShaderTextureNamePrefix("material.");
-
-    Model door("resources/objects/wooden_door/scene.gltf");
-    door.SetShaderTextureNamePrefix("material.");
-
-    Model HK("resources/objects/hollowKnight2/untitled.obj");
-    HK.SetShaderTextureNamePrefix("material.");
-
-    Model notebook("resources/objects/notebook/scene.gltf");
-    notebook.SetShaderTextureNamePrefix("material.");
-
-    // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
-    stbi_set_flip_vertically_on_load(true);
+    // everything below loads in the background: the render loop starts right away, draws whatever is ready and uploads the
+    // rest within a few milliseconds per frame, most important on screen first
+    AssetLoader assets;
+    // models are loaded while the camera is near them and released again once it moves away. Meshes are packed with only
+    // the vertex attributes the model shader declares.
+    ResidencyManager residency(assets, VertexLayout::FromShader("resources/shaders/2.model_lighting.vs"));
+    // nothing reads mesh vertices back on the CPU, so only the GPU copy is kept
+    residency.KeepGeometry(false);
+
+    // objects are placed by the scene file, so they can be added or moved without recompiling. Each model file is
+    // streamed in around whichever of its instances is nearest to the camera.
+    SceneGraph &scene = programState->scene;
+    SceneGraph::Load("resources/scenes/hollow_knight.json", scene);
+    ObjectTransforms transforms;
+    scene.UpdateWorld(transforms);
+    std::vector<AssetHandle<Model>> models;
+    for (int i = 0; i < scene.ModelCount(); i++)
+    {
+        models.push_back(residency.Track(scene.ModelPath(i), [&scene, i](const glm::vec3 &camera) {
+            return scene.NearestInstance(i, camera);
+        }, scene.ModelScale(i)));
+        models.back()->SetShaderTextureNamePrefix(scene.TexturePrefix());
+    }
+    // the grimmchild bobs below its anchor, and one of the point lights follows it
+    int ghost = scene.Find("ghost");
+    int grimmchild = scene.Find("grimmchild");
+    glm::vec3 grimmchildRest = grimmchild >= 0 ? scene.Position(grimmchild) : glm::vec3(0.0f);
+    ourShader.use();
+    ourShader.setInt("objectTransforms", ObjectTransforms::Unit);
 
 
     //hdr---------------------------------------------------------------------------------------------------------
-    unsigned int VAO, VBO, RBO;
-    unsigned int framebuffer;
-    unsigned int colorBuffers[2];
-    unsigned int pingpongFBO[2], pingpongColorBuffers[2];
+    VertexArrayHandle VAO = CreateVertexArray();
+    BufferHandle VBO = CreateBuffer();
+    RenderbufferHandle RBO = CreateRenderbuffer();
+    FramebufferHandle framebuffer = CreateFramebuffer();
+    TextureHandle colorBuffers[2] = {CreateTexture(), CreateTexture()};
+    FramebufferHandle pingpongFBO[2] = {CreateFramebuffer(), CreateFramebuffer()};
+    TextureHandle pingpongColorBuffers[2] = {CreateTexture(), CreateTexture()};
 
     hdrBloomShader.use();
     hdrBloomShader.setInt("scene", 0);
@@ -284,11 +314,8 @@ int main() {
             1.0f,  1.0f,  1.0f, 1.0f
     };
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindVertexArray(VAO.get());
+    glBindBuffer(GL_ARRAY_BUFFER, VBO.get());
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices),&vertices, GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0);
@@ -296,47 +323,42 @@ int main() {
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
 
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.get());
 
 
-    glGenTextures(2, colorBuffers);
     for (int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
+        glBindTexture(GL_TEXTURE_2D, colorBuffers[i].get());
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, framebufferWidth,framebufferHeight, 0, GL_RGBA, GL_FLOAT, nullptr);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
-                               GL_TEXTURE_2D, colorBuffers[i], 0);
+                               GL_TEXTURE_2D, colorBuffers[i].get(), 0);
     }
 
 
     unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
     glDrawBuffers(2, attachments);
 
-    glGenRenderbuffers(1, &RBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, RBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, RBO.get());
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT ,framebufferWidth, framebufferHeight);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, RBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, RBO.get());
 
     if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
         std::cerr << "Framebuffer is not complete!" << std::endl;
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorBuffers);
     for (int i = 0; i < 2; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorBuffers[i]);
+        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i].get());
+        glBindTexture(GL_TEXTURE_2D, pingpongColorBuffers[i].get());
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, framebufferWidth,framebufferHeight, 0, GL_RGBA, GL_FLOAT , nullptr);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D, pingpongColorBuffers[i], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D, pingpongColorBuffers[i].get(), 0);
         if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
             std::cerr << "Pingpong framebuffer is not complete!" << std::endl;
         }
@@ -407,11 +429,10 @@ int main() {
             1.0f, -1.0f,  1.0f
     };
 //--------------------skyboxVAO-------------------------------
-    unsigned int skyboxVAO, skyboxVBO;
-    glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
+    VertexArrayHandle skyboxVAO = CreateVertexArray();
+    BufferHandle skyboxVBO = CreateBuffer();
+    glBindVertexArray(skyboxVAO.get());
+    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO.get());
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -427,7 +448,7 @@ int main() {
                     FileSystem::getPath("resources/Skybox_textures/front.png")
             };
 
-    unsigned int cubemapTexture = loadCubemap(faces);
+    AssetHandle<TextureHandle> skybox = loadCubemap(assets, faces);
 
     skyboxShader.use();
     skyboxShader.setInt("skybox", 0);
@@ -445,10 +466,21 @@ int main() {
         // -----
         processInput(window);
 
+        residency.Update(programState->camera.Position, programState->camera.Front);
+        assets.Poll(std::chrono::milliseconds(4));
+        textureStreamer.Update();
+        if (LoadProfiler::Instance().Enabled() && textureStreamer.Idle() && assets.Pending() == 0) {
+            LoadProfiler::Instance().Finish(FileSystem::getPath("startup"));
+            residency.PrintStats();
+            TextureRegistry::Instance().PrintStats();
+            GeometryBuffers::Instance().PrintStats();
+            VirtualFileSystem::Instance().PrintStats();
+        }
+
 
         //----------------
         glViewport(0, 0, framebufferWidth, framebufferHeight);
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.get());
         glEnable(GL_DEPTH_TEST);
 
         //--------------------
@@ -460,58 +492,34 @@ int main() {
 
 
 
-        // point lights
-        ourShader.use();
+        if (grimmchild >= 0)
+            scene.SetPosition(grimmchild, grimmchildRest + glm::vec3(0.0f, cos(currentFrame)*2, 0.0f));
+        // only nodes that moved since the last frame get new matrices
+        scene.UpdateWorld(transforms);
+        glm::vec3 ghostPosition = ghost >= 0 ? scene.WorldPosition(ghost) : glm::vec3(0.0f);
+
+        // point lights; the light and frame blocks are shared by every program and only uploaded when they change
+        LightUniforms &lights = lightUniforms.Data();
         pointLight.position = glm::vec3(-9.0f, 2.1f, 22.0f);
-        ourShader.setVec3("pointLight[0].position", pointLight.position);
-        ourShader.setVec3("pointLight[0].ambient", pointLight.ambient);
-        ourShader.setVec3("pointLight[0].diffuse", glm::vec3(10.0f));
-        ourShader.setVec3("pointLight[0].specular", pointLight.specular);
-        ourShader.setFloat("pointLight[0].constant", pointLight.constant);
-        ourShader.setFloat("pointLight[0].linear", pointLight.linear);
-        ourShader.setFloat("pointLight[0].quadratic", pointLight.quadratic);
-        ourShader.setVec3("color[0]", color1);
-        ourShader.setVec3("viewPosition", programState->camera.Position);
-        ourShader.setFloat("material.shininess", 32.0f);
-
-        pointLight.position = programState->ghostPosition + glm::vec3(0.7f, 0.5+ cos(currentFrame)*2, 0.4f);
-        ourShader.setVec3("pointLight[1].position", pointLight.position);
-        ourShader.setVec3("pointLight[1].ambient", pointLight.ambient);
-        ourShader.setVec3("pointLight[1].diffuse", glm::vec3(250.0f));
-        ourShader.setVec3("pointLight[1].specular", pointLight.specular);
-        ourShader.setFloat("pointLight[1].constant", pointLight.constant);
-        ourShader.setFloat("pointLight[1].linear", 0.7f);
-        ourShader.setFloat("pointLight[1].quadratic", 1.8f);
-        ourShader.setVec3("color[1]", color2);
+        setPointLight(lights.pointLight[0], pointLight, glm::vec3(10.0f), pointLight.linear, pointLight.quadratic, color1);
 
-        pointLight.position = glm::vec3(-0.3f, 1.3f, 12.8f);
-        ourShader.setVec3("pointLight[2].position", pointLight.position);
-        ourShader.setVec3("pointLight[2].ambient", pointLight.ambient);
-        ourShader.setVec3("pointLight[2].diffuse", glm::vec3(15.0f));
-        ourShader.setVec3("pointLight[2].specular", pointLight.specular);
-        ourShader.setFloat("pointLight[2].constant", pointLight.constant);
-        ourShader.setFloat("pointLight[2].linear", 0.7f);
-        ourShader.setFloat("pointLight[2].quadratic", 1.8f);
-        ourShader.setVec3("color[2]", glm::vec3(1.0f, 1.0f, 1.0f));
+        pointLight.position = ghostPosition + glm::vec3(0.7f, 0.5+ cos(currentFrame)*2, 0.4f);
+        setPointLight(lights.pointLight[1], pointLight, glm::vec3(250.0f), 0.7f, 1.8f, color2);
 
+        pointLight.position = glm::vec3(-0.3f, 1.3f, 12.8f);
+        setPointLight(lights.pointLight[2], pointLight, glm::vec3(15.0f), 0.7f, 1.8f, glm::vec3(1.0f, 1.0f, 1.0f));
 
         pointLight.position = glm::vec3(0.23f, 1.3f, 12.8f);
-        ourShader.setVec3("pointLight[3].position", pointLight.position);
-        ourShader.setVec3("pointLight[3].ambient", pointLight.ambient);
-        ourShader.setVec3("pointLight[3].diffuse", glm::vec3(15.0f));
-        ourShader.setVec3("pointLight[3].specular", pointLight.specular);
-        ourShader.setFloat("pointLight[3].constant", pointLight.constant);
-        ourShader.setFloat("pointLight[3].linear", 0.7f);
-        ourShader.setFloat("pointLight[3].quadratic", 1.8f);
-        ourShader.setVec3("color[3]", glm::vec3(1.0f, 1.0f, 1.0f));
+        setPointLight(lights.pointLight[3], pointLight, glm::vec3(15.0f), 0.7f, 1.8f, glm::vec3(1.0f, 1.0f, 1.0f));
 
 
         //Directional Light
-        ourShader.setVec3("dirLight.direction", glm::vec3(0.2f, -0.7f, 0.2f));
-        ourShader.setVec3("dirLight.ambient", glm::vec3(0.25f));
-        ourShader.setVec3("dirLight.diffuse", glm::vec3(0.35f));
-        ourShader.setVec3("dirLight.specular", glm::vec3(0.45f));
-        ourShader.setVec3("lightColor", glm::vec3(0.0f, 0.8f, 1.0f));
+        lights.dirLight.direction = glm::vec3(0.2f, -0.7f, 0.2f);
+        lights.dirLight.ambient = glm::vec3(0.25f);
+        lights.dirLight.diffuse = glm::vec3(0.35f);
+        lights.dirLight.specular = glm::vec3(0.45f);
+        lights.lightColor = glm::vec3(0.0f, 0.8f, 1.0f);
+        lightUniforms.Update();
 
 
 
@@ -519,125 +527,40 @@ int main() {
         glm::mat4 projection = glm::perspective(glm::radians(programState->camera.Zoom),
                                                 (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = programState->camera.GetViewMatrix();
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("view", view);
-
-
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->hornetPosition);
-        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.7f));
-        ourShader.setMat4("model", model);
-        hornet.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->hollowknightPosition);
-        model = glm::rotate(model, glm::radians(-180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.02f));
-        ourShader.setMat4("model", model);
-        hollowknight.Draw(ourShader);
-
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->tablePosition);
-        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->tableScale));
-        ourShader.setMat4("model", model);
-        table.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->paintbrushPosition);
-        model = glm::rotate(model, glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->paintbrushScale));
-        ourShader.setMat4("model", model);
-        paintBrush.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->statuePosition);
-        model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->statueScale));
-        ourShader.setMat4("model", model);
-        statue.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->gemPosition);
-        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->gemScale));
-        ourShader.setMat4("model", model);
-        gem.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->candlePosition);
-        model = glm::scale(model, glm::vec3(programState->candleScale));
-        ourShader.setMat4("model", model);
-        candle.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->booksPosition);
-        model = glm::rotate(model, glm::radians(-30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->booksScale));
-        ourShader.setMat4("model", model);
-        books.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->ghostPosition + glm::vec3(0.0f, cos(currentFrame)*2, 0.0f));
-        model = glm::rotate(model, glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->ghostScale));
-        ourShader.setMat4("model", model);
-        ghost.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->rubikscubePosition);
-        model = glm::rotate(model, glm::radians(25.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->rubikscubeScale));
-        ourShader.setMat4("model", model);
-        rubiksCube.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->bushPosition);
-        model = glm::rotate(model, glm::radians(20.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->bushScale));
-        ourShader.setMat4("model", model);
-        bush1.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->doorPosition);
-        model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->doorScale));
-        ourShader.setMat4("model", model);
-        door.Draw(ourShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->HKPosition);
-        model = glm::scale(model, glm::vec3(programState->HKScale));
-        ourShader.setMat4("model", model);
-        HK.Draw(ourShader);
-
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, programState->notebookPosition);
-        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(programState->notebookScale));
-        ourShader.setMat4("model", model);
-        notebook.Draw(ourShader);
+        FrameUniforms &frame = frameUniforms.Data();
+        frame.projection = projection;
+        frame.view = view;
+        frame.viewPosition = programState->camera.Position;
+        frameUniforms.Update();
 
+        ourShader.use();
+        ourShader.setFloat(MaterialShininess, 32.0f);
 
-//------------------------------------------------
-        glDepthMask(GL_FALSE);
-        glDepthFunc(GL_LEQUAL);
-        skyboxShader.use();
 
-        skyboxShader.setMat4("projection", projection);
-        skyboxShader.setMat4("view", glm::mat4(glm::mat3(view)));
+        transforms.Update();
+        transforms.Bind();
+        scene.ForEachDrawable([&](unsigned int object, int model) {
+            if (!models[model])
+                return;
+            ourShader.setInt(ObjectIndex, object);
+            models[model]->Draw(ourShader);
+        });
 
-        glBindVertexArray(skyboxVAO);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glDepthMask(GL_TRUE);
 
-        glDepthFunc(GL_LESS);
+//------------------------------------------------
+        // the clear color stands in for the sky until the cubemap is loaded
+        if (skybox) {
+            glDepthMask(GL_FALSE);
+            glDepthFunc(GL_LEQUAL);
+            skyboxShader.use();
+
+            glBindVertexArray(skyboxVAO.get());
+            glBindTexture(GL_TEXTURE_CUBE_MAP, skybox->get());
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glDepthMask(GL_TRUE);
+
+            glDepthFunc(GL_LESS);
+        }
 
 
 
@@ -652,13 +575,13 @@ int main() {
         blurShader.use();
 
 
-        glBindVertexArray(VAO);
+        glBindVertexArray(VAO.get());
         for (unsigned int i = 0; i < amount; i++) {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            blurShader.setInt("horizontal", horizontal);
+            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal].get());
+            blurShader.setInt(Horizontal, horizontal);
 
             glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, firstIteration ? colorBuffers[1] : pingpongColorBuffers[!horizontal]);
+            glBindTexture(GL_TEXTURE_2D, firstIteration ? colorBuffers[1].get() : pingpongColorBuffers[!horizontal].get());
 
             glDrawArrays(GL_TRIANGLES, 0, 6);
 
@@ -675,14 +598,14 @@ int main() {
 
         hdrBloomShader.use();
 
-        hdrBloomShader.setBool("hdr", programState->hdr);
-        hdrBloomShader.setBool("bloom", programState->bloom);
-        hdrBloomShader.setFloat("exposure", programState->exposure);
+        hdrBloomShader.setBool(Hdr, programState->hdr);
+        hdrBloomShader.setBool(Bloom, programState->bloom);
+        hdrBloomShader.setFloat(Exposure, programState->exposure);
 
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
+        glBindTexture(GL_TEXTURE_2D, colorBuffers[0].get());
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorBuffers[!horizontal]);
+        glBindTexture(GL_TEXTURE_2D, pingpongColorBuffers[!horizontal].get());
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindVertexArray(0);
 
@@ -696,27 +619,9 @@ int main() {
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
+        LoadProfiler::Instance().FirstFrame();
         glfwPollEvents();
     }
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteRenderbuffers(1, &RBO);
-
-    glDeleteFramebuffers(1, &framebuffer);
-    glDeleteFramebuffers(2, pingpongFBO);
-
-    glDeleteTextures(2, colorBuffers);
-    glDeleteTextures(2, pingpongColorBuffers);
-
-    programState->SaveToFile("resources/program_state.txt");
-    delete programState;
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    // ------------------------------------------------------------------
-    glfwTerminate();
-    return 0;
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
@@ -792,10 +697,24 @@ void DrawImGui(ProgramState *programState) {
         ImGui::Text("Hello text");
         ImGui::SliderFloat("Float slider", &f, 0.0, 1.0);
         ImGui::ColorEdit3("Background color", (float *) &programState->clearColor);
-        ImGui::DragFloat3("ghost position", (float*)&programState->ghostPosition);
-        ImGui::DragFloat3("hornet position", (float*)&programState->hornetPosition);
-        ImGui::DragFloat3("np position", (float*)&programState->notebookPosition);
-        ImGui::DragFloat("np scale", &programState->notebookScale, 0.05, 0.1, 40.0);
+
+        SceneGraph &scene = programState->scene;
+        if (scene.NodeCount() > 0) {
+            int &selected = programState->selectedNode;
+            selected = std::min(selected, scene.NodeCount() - 1);
+            if (ImGui::BeginCombo("object", scene.Name(selected).c_str())) {
+                for (int i = 0; i < scene.NodeCount(); i++)
+                    if (ImGui::Selectable(scene.Name(i).c_str(), i == selected))
+                        selected = i;
+                ImGui::EndCombo();
+            }
+            glm::vec3 position = scene.Position(selected);
+            if (ImGui::DragFloat3("position", (float*)&position))
+                scene.SetPosition(selected, position);
+            float scale = scene.Scale(selected).x;
+            if (ImGui::DragFloat("scale", &scale, 0.05, 0.01, 100.0))
+                scene.SetScale(selected, glm::vec3(scale));
+        }
 
 
         ImGui::DragFloat("pointLight.constant", &programState->pointLight.constant, 0.05, 0.0, 1.0);
@@ -834,34 +753,15 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
         programState->bloom = !programState->bloom;
 }
 
-unsigned int loadCubemap(vector<std::string> faces) {
-    stbi_set_flip_vertically_on_load(true);
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-    for (unsigned int i = 0; i < faces.size(); i++)
-    {
-        unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                         0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data
-            );
-            stbi_image_free(data);
-        }
-        else
-        {
-            std::cout << "Cubemap tex failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
-        }
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    return textureID;
+// loads the baked cubemap (or decodes and bakes the faces) on a loader thread and uploads it on the GL thread
+AssetHandle<TextureHandle> loadCubemap(AssetLoader &loader, vector<std::string> faces) {
+    auto load = [faces]() { return LoadCubemapImage(faces); };
+    auto upload = [faces](TextureHandle &texture, CubemapImage &image) {
+        texture.reset(CubemapFromImage(image, faces[0]));
+        bool loaded = image.HasData();
+        image = CubemapImage();
+        return loaded;
+    };
+    // it fills the whole view, so it goes ahead of the models (importance <= 1); the clear color stands in until then
+    return loader.Load<TextureHandle>(load, upload, 2.0f);
 }
\ No newline at end of file
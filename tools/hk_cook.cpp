@@ -0,0 +1,357 @@
+// Offline asset cooker: prepares everything the game would otherwise build on its first run.
+//
+//   hk_cook [--force] [--no-pack] [--jobs N]
+//
+// Run from the project root. Every model under resources/objects is imported, welded and optimized into the mesh cache,
+// every texture it references is block-compressed into the texture cache, and resources.hkpack is rebuilt from the
+// result (see hk_pack). All of it runs on a thread pool, the models first and then the union of their textures.
+//
+// A dependency graph in resources/cache/cook_graph.json records, for every cooked output, the content hash of each input
+// file and a key made of the tool and cache format versions plus the import profile or texture usage. Inputs whose size
+// and modification time are unchanged are not even rehashed, so a re-run only recooks what changed and repacks only if
+// something did. --force ignores the graph.
+#include <learnopengl/filesystem.h>
+#include <learnopengl/json.h>
+#include <learnopengl/model.h>
+#include <learnopengl/resource_pack_writer.h>
+#include <learnopengl/texture_compress.h>
+#include <learnopengl/thread_pool.h>
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// bump to invalidate every recorded output when the cooking itself changes
+static const uint32_t ToolVersion = 1;
+
+static const char *GraphPath = "resources/cache/cook_graph.json";
+static const char *PackPath = "resources.hkpack";
+
+static std::string hex(uint64_t value)
+{
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", (unsigned long long) value);
+    return text;
+}
+
+static std::string quoted(const std::string &text)
+{
+    std::string result = "\"";
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result + "\"";
+}
+
+static bool exists(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+// Inputs, outputs and keys of everything cooked by the previous run, and the file stamps that let unchanged inputs skip
+// hashing. Thread-safe.
+class CookGraph
+{
+public:
+    struct Input {
+        std::string path;
+        uint64_t hash;
+    };
+
+    struct Node {
+        uint64_t key = 0;
+        std::string output;             // empty when cooking produced nothing, e.g. an image that stays uncompressed
+        std::vector<Input> inputs;
+        std::vector<TextureRef> textures;   // models only: the textures their meshes reference, by canonical path
+    };
+
+    void Load(const std::string &path)
+    {
+        FileView file = VirtualFileSystem::Instance().OpenLoose(path);
+        JsonValue document;
+        if (!file || !JsonValue::Parse(file.String(), document) || document["version"].Int() != (int) ToolVersion)
+            return;
+        const JsonValue &files = document["files"];
+        for (size_t i = 0; i < files.Size(); i++)
+        {
+            Stamp stamp;
+            stamp.size = (int64_t) files[i]["size"].Number();
+            stamp.modified = (int64_t) files[i]["modified"].Number();
+            stamp.hash = strtoull(files[i]["hash"].String().c_str(), nullptr, 16);
+            stamps[files[i]["path"].String()] = stamp;
+        }
+        const JsonValue &nodeList = document["nodes"];
+        for (size_t i = 0; i < nodeList.Size(); i++)
+        {
+            const JsonValue &json = nodeList[i];
+            Node node;
+            node.key = strtoull(json["key"].String().c_str(), nullptr, 16);
+            node.output = json["output"].String();
+            for (size_t j = 0; j < json["inputs"].Size(); j++)
+                node.inputs.push_back(Input{json["inputs"][j]["path"].String(),
+                                            strtoull(json["inputs"][j]["hash"].String().c_str(), nullptr, 16)});
+            for (size_t j = 0; j < json["textures"].Size(); j++)
+                node.textures.push_back(TextureRef{json["textures"][j]["type"].String(), json["textures"][j]["path"].String()});
+            nodes[json["id"].String()] = node;
+        }
+    }
+
+    bool Save(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string tempPath = path + ".tmp";
+        std::ofstream out(tempPath, std::ios::trunc);
+        out << "{\n  \"version\": " << ToolVersion << ",\n  \"files\": [";
+        const char *separator = "\n";
+        for (const auto &stamp : stamps)
+        {
+            out << separator << "    {\"path\": " << quoted(stamp.first) << ", \"size\": " << stamp.second.size
+                << ", \"modified\": " << stamp.second.modified << ", \"hash\": \"" << hex(stamp.second.hash) << "\"}";
+            separator = ",\n";
+        }
+        out << "\n  ],\n  \"nodes\": [";
+        separator = "\n";
+        for (const auto &entry : nodes)
+        {
+            const Node &node = entry.second;
+            out << separator << "    {\"id\": " << quoted(entry.first) << ", \"key\": \"" << hex(node.key) << "\", \"output\": "
+                << quoted(node.output) << ",\n     \"inputs\": [";
+            for (size_t i = 0; i < node.inputs.size(); i++)
+                out << (i ? ", " : "") << "{\"path\": " << quoted(node.inputs[i].path) << ", \"hash\": \"" << hex(node.inputs[i].hash) << "\"}";
+            out << "],\n     \"textures\": [";
+            for (size_t i = 0; i < node.textures.size(); i++)
+                out << (i ? ", " : "") << "{\"type\": " << quoted(node.textures[i].type) << ", \"path\": " << quoted(node.textures[i].path) << "}";
+            out << "]}";
+            separator = ",\n";
+        }
+        out << "\n  ]\n}\n";
+        out.close();
+        if (!out || rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            std::cout << "ERROR::HK_COOK:: could not write " << path << std::endl;
+            remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // content hash of path, taken from the previous run when its size and modification time are unchanged; 0 if missing
+    uint64_t Hash(const std::string &path)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            return 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = stamps.find(path);
+            if (found != stamps.end() && found->second.size == (int64_t) st.st_size && found->second.modified == (int64_t) st.st_mtime)
+                return found->second.hash;
+        }
+        MappedFile file(path);
+        Stamp stamp;
+        stamp.size = st.st_size;
+        stamp.modified = st.st_mtime;
+        stamp.hash = file.IsOpen() ? HashContent(file.data, file.size) : HashContent(nullptr, 0);
+        std::lock_guard<std::mutex> lock(mutex);
+        stamps[path] = stamp;
+        return stamp.hash;
+    }
+
+    // the node recorded under id if it was cooked with key from inputs that are all unchanged and its output is there
+    bool UpToDate(const std::string &id, uint64_t key, const std::vector<std::string> &inputs, Node &node)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = nodes.find(id);
+            if (found == nodes.end())
+                return false;
+            node = found->second;
+        }
+        if (node.key != key || node.inputs.size() != inputs.size() || (!node.output.empty() && !exists(node.output)))
+            return false;
+        for (size_t i = 0; i < inputs.size(); i++)
+            if (node.inputs[i].path != inputs[i] || node.inputs[i].hash != Hash(inputs[i]))
+                return false;
+        return true;
+    }
+
+    void Record(const std::string &id, uint64_t key, const std::vector<std::string> &inputs, const std::string &output,
+                const std::vector<TextureRef> &textures = std::vector<TextureRef>())
+    {
+        Node node;
+        node.key = key;
+        node.output = output;
+        node.textures = textures;
+        for (const std::string &input : inputs)
+            node.inputs.push_back(Input{input, Hash(input)});
+        std::lock_guard<std::mutex> lock(mutex);
+        nodes[id] = node;
+    }
+
+private:
+    struct Stamp {
+        int64_t size = 0;
+        int64_t modified = 0;
+        uint64_t hash = 0;
+    };
+
+    std::mutex mutex;
+    std::map<std::string, Stamp> stamps;
+    std::map<std::string, Node> nodes;
+};
+
+static bool isModel(const std::string &path)
+{
+    static const char *extensions[] = {".gltf", ".glb", ".obj", ".fbx", ".dae"};
+    for (const char *extension : extensions)
+    {
+        size_t length = strlen(extension);
+        if (path.size() > length && path.compare(path.size() - length, length, extension) == 0)
+            return true;
+    }
+    return false;
+}
+
+// the model file plus the companion files HashModelSource folds into its cache key
+static std::vector<std::string> modelInputs(const std::string &path)
+{
+    std::vector<std::string> inputs = {path};
+    std::string stem = path.substr(0, path.find_last_of('.'));
+    for (const std::string &companion : {stem + ".bin", stem + ".mtl"})
+        if (exists(companion))
+            inputs.push_back(companion);
+    return inputs;
+}
+
+int main(int argc, char *argv[])
+{
+    bool force = false, pack = true;
+    unsigned int jobs = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--force") == 0)
+            force = true;
+        else if (strcmp(argv[i], "--no-pack") == 0)
+            pack = false;
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+            jobs = std::max(1, atoi(argv[++i]));
+        else
+        {
+            std::cout << "usage: hk_cook [--force] [--no-pack] [--jobs N]" << std::endl;
+            return 1;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    // cooked S3TC is what desktop GL 3.3 drivers sample; the game falls back to the source image where it is missing
+    TextureCompression::S3TCSupported() = true;
+
+    CookGraph graph;
+    if (!force)
+        graph.Load(GraphPath);
+    ThreadPool workers(jobs);
+    std::atomic<int> cooked(0), failed(0);
+
+    std::vector<std::string> models;
+    std::vector<std::string> files;
+    FileSystem::listFiles("resources/objects", files);
+    for (const std::string &file : files)
+        if (isModel(file))
+            models.push_back(file);
+
+    // models first: their imports tell which textures there are
+    std::mutex texturesMutex;
+    std::set<std::pair<std::string, int>> textures;   // canonical path, usage
+    for (const std::string &path : models)
+    {
+        workers.Submit([&, path]() {
+            ImportProfile profile = ImportProfile::ForModel(path);
+            uint64_t key = HashBytes(&ToolVersion, sizeof(ToolVersion), MeshCache::Version ^ profile.Key());
+            std::vector<std::string> inputs = modelInputs(path);
+            std::string id = "mesh:" + path;
+            CookGraph::Node node;
+            std::vector<TextureRef> references;
+            if (graph.UpToDate(id, key, inputs, node))
+                references = node.textures;
+            else
+            {
+                ModelData data;
+                if (!Model::ImportGeometry(path, data))
+                {
+                    std::cout << "ERROR::HK_COOK:: could not import " << path << std::endl;
+                    failed++;
+                    return;
+                }
+                std::set<std::string> seen;
+                for (const MeshData &mesh : data.meshes)
+                    for (const TextureRef &ref : mesh.textures)
+                        if (seen.insert(ref.type + ref.path).second)
+                            references.push_back(TextureRef{ref.type, CanonicalPath(data.directory + '/' + ref.path)});
+                graph.Record(id, key, inputs, MeshCache::EntryPath(path, profile.Key()), references);
+                std::cout << "HK_COOK:: mesh " << path << std::endl;
+                cooked++;
+            }
+            std::lock_guard<std::mutex> lock(texturesMutex);
+            for (const TextureRef &ref : references)
+                textures.insert(std::make_pair(ref.path, (int) Model::TextureUsage(ref)));
+        });
+    }
+    workers.Wait();
+
+    for (const auto &texture : textures)
+    {
+        workers.Submit([&, texture]() {
+            const std::string &path = texture.first;
+            TextureCompression::Usage usage = (TextureCompression::Usage) texture.second;
+            uint64_t key = HashBytes(&ToolVersion, sizeof(ToolVersion), TextureCompression::Version * 31 + usage);
+            std::vector<std::string> inputs = {path};
+            std::string id = "texture:" + path + (usage == TextureCompression::Normal ? ":normal" : ":color");
+            CookGraph::Node node;
+            if (graph.UpToDate(id, key, inputs, node))
+                return;
+            if (!exists(path))
+            {
+                // referenced by a model but not shipped; the game logs it when loading
+                graph.Record(id, key, std::vector<std::string>(), "");
+                return;
+            }
+            ImageData image = LoadTextureImage(path, usage);
+            std::string output = image.compressedFormat != 0 ? TextureCompression::CookedPath(path) : "";
+            graph.Record(id, key, inputs, output);
+            std::cout << "HK_COOK:: texture " << path << (output.empty() ? " (left uncompressed)" : "") << std::endl;
+            cooked++;
+        });
+    }
+    workers.Wait();
+    graph.Save(GraphPath);
+
+    if (pack && (cooked > 0 || !exists(PackPath)))
+    {
+        ResourcePackWriter writer;
+        writer.AddDirectory("resources", std::vector<std::string>(), workers);
+        if (writer.Write(PackPath))
+            std::cout << "HK_COOK:: " << PackPath << ": " << writer.FileCount() << " files, " << writer.StoredBytes() / 1024 << " KB"
+                      << std::endl;
+        else
+            failed++;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "HK_COOK:: " << models.size() << " models, " << textures.size() << " textures, " << cooked << " cooked, "
+              << failed << " failed in " << seconds << " s" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
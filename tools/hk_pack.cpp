@@ -0,0 +1,37 @@
+// Builds the resource pack the game mounts at startup (see VirtualFileSystem).
+//
+//   hk_pack [output] [directory...]
+//
+// Defaults to packing resources/ into resources.hkpack; run it from the project root so the stored paths match the ones
+// the game opens. Text and geometry are LZ4 compressed where that pays off, images are stored as they are. The mesh and
+// texture caches under resources/cache are packed too, so run hk_cook first to ship them up to date.
+#include <learnopengl/resource_pack_writer.h>
+#include <learnopengl/thread_pool.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    std::string output = argc > 1 ? argv[1] : "resources.hkpack";
+    std::vector<std::string> directories;
+    for (int i = 2; i < argc; i++)
+        directories.push_back(argv[i]);
+    if (directories.empty())
+        directories.push_back("resources");
+
+    ThreadPool workers;
+    ResourcePackWriter writer;
+    for (std::string directory : directories)
+    {
+        while (directory.size() > 1 && directory.back() == '/')
+            directory.pop_back();
+        writer.AddDirectory(directory, std::vector<std::string>(), workers);
+    }
+    if (!writer.Write(output))
+        return 1;
+    std::cout << "HK_PACK:: " << output << ": " << writer.FileCount() << " files, " << writer.RawBytes() / 1024 << " KB -> "
+              << writer.StoredBytes() / 1024 << " KB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Times ObjLoader against ASSIMP's OBJ importer on the same file with the model's ImportProfile.
+//
+//   obj_benchmark [path] [runs]
+//
+// The ASSIMP figure only covers ReadFile with the profile's post-processing, not the conversion to Vertex that
+// Model::processNode does afterwards, so it is a lower bound for the path the native loader replaces. Run it twice to
+// compare a cold and a warm page cache.
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <learnopengl/import_profile.h>
+#include <learnopengl/obj_loader.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// runs import the given number of times and prints the fastest and the median run in milliseconds
+static void report(const std::string &name, int runs, const std::function<void()> &import)
+{
+    std::vector<double> times;
+    for (int i = 0; i < runs; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        import();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(2)
+              << " min " << std::setw(8) << times.front() << " ms   median " << std::setw(8) << times[times.size() / 2] << " ms"
+              << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string path = argc > 1 ? argv[1] : "resources/objects/hollowKnight2/untitled.obj";
+    int runs = argc > 2 ? std::max(1, atoi(argv[2])) : 10;
+    ImportProfile profile = ImportProfile::ForModel(path);
+
+    size_t meshCount = 0, vertexCount = 0, triangleCount = 0;
+    report("ASSIMP", runs, [&]() {
+        Assimp::Importer importer;
+        const aiScene *scene = importer.ReadFile(path, profile.PostProcessFlags());
+        if (!scene)
+        {
+            std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+            exit(1);
+        }
+        meshCount = scene->mNumMeshes;
+        vertexCount = triangleCount = 0;
+        for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+        {
+            vertexCount += scene->mMeshes[i]->mNumVertices;
+            triangleCount += scene->mMeshes[i]->mNumFaces;
+        }
+    });
+    std::cout << "    " << meshCount << " meshes, " << vertexCount << " vertices, " << triangleCount << " triangles" << std::endl;
+
+    unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads : {1u, hardwareThreads})
+    {
+        ThreadPool pool(threads);
+        std::vector<MeshData> meshes;
+        report("ObjLoader, " + std::to_string(threads) + " thread(s)", runs, [&]() {
+            meshes.clear();
+            if (!ObjLoader(pool).Load(path, profile, meshes))
+                exit(1);
+        });
+        vertexCount = triangleCount = 0;
+        for (const MeshData &mesh : meshes)
+        {
+            vertexCount += mesh.vertices.size();
+            triangleCount += mesh.indices.size() / 3;
+        }
+        std::cout << "    " << meshes.size() << " meshes, " << vertexCount << " vertices, " << triangleCount << " triangles" << std::endl;
+        if (hardwareThreads == 1)
+            break;
+    }
+    return 0;
+}